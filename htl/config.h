@@ -96,7 +96,7 @@
 #define HTL_ARCH_ALPHA 1
 #endif
 
-#if !defined(HTL_DEBUG) && defined(NDEBUG)
+#if !defined(HTL_DEBUG) && !defined(NDEBUG)
 #define HTL_DEBUG 1
 #endif
 
@@ -20,6 +20,8 @@ private:
     SipHash _base;
 
 public:
+    static constexpr std::size_t digest_size = SipHash::digest_size;
+
     DefaultHasher() noexcept : _base(siphash_key) {}
 
     auto &reset() noexcept
@@ -28,6 +30,12 @@ public:
         return *this;
     }
 
+    auto &update(const std::uint8_t *data, std::size_t size) noexcept
+    {
+        _base.update(data, size);
+        return *this;
+    }
+
     template <class T>
         requires std::has_unique_object_representations_v<T>
     auto &update(const T &value) noexcept
@@ -53,7 +61,7 @@ public:
         if constexpr (std::contiguous_iterator<I> &&
                       std::sized_sentinel_for<S, I>) {
             _base.update(
-                reinterpret_cast<const std::byte *>(std::addressof(*first)),
+                reinterpret_cast<const std::uint8_t *>(std::addressof(*first)),
                 sizeof(std::iter_value_t<I>) *
                     std::ranges::distance(first, last));
         } else {
@@ -66,6 +74,11 @@ public:
         return *this;
     }
 
+    void finalize(std::uint8_t *dest) noexcept
+    {
+        _base.finalize(dest);
+    }
+
     std::uint64_t digest() noexcept
     {
         std::uint8_t dest[SipHash::digest_size];
@@ -1,26 +1,46 @@
 #ifndef HTL_DETAIL_JSON_H_
 #define HTL_DETAIL_JSON_H_
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <charconv>
 #include <climits>
 #include <cmath>
 #include <concepts>
+#include <cstring>
 #include <cuchar>
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 #include <cxxabi.h>
 #include <htl/ascii.h>
 #include <htl/detail/encoding.h>
+#include <htl/detail/json_simd.h>
 #include <htl/jsonfwd.h>
+#include <htl/type_traits.h>
+#include <htl/unaligned.h>
 
 namespace htl::json::detail {
 
+// Whether documents using `Alloc` may skip destroying their values, because
+// the allocator never frees memory.
+template <class Alloc>
+inline constexpr bool skips_destruction = false;
+
+template <class T>
+inline constexpr bool skips_destruction<ArenaAllocator<T>> = true;
+
 template <class I, class S>
 inline auto make_common_iterator(auto it)
 {
@@ -31,6 +51,60 @@ inline auto make_common_iterator(auto it)
     }
 }
 
+template <class I, class S>
+concept contiguous_input =
+    std::contiguous_iterator<I> && std::sized_sentinel_for<S, I> &&
+    (is_char_v<std::iter_value_t<I>> || is_byte_v<std::iter_value_t<I>>) &&
+    sizeof(std::iter_value_t<I>) == 1;
+
+template <std::contiguous_iterator I>
+inline const char *to_char_pointer(I it) noexcept
+{
+    return reinterpret_cast<const char *>(std::to_address(it));
+}
+
+struct TextPosition {
+    int line;
+    int column;
+};
+
+// Zero based line and column of `pos`. Each of "\r\n", "\r", and "\n" ends a
+// line, and columns count bytes.
+inline TextPosition locate(const char *first, const char *pos) noexcept
+{
+    auto is_line_break = [](char c) { return c == '\n' || c == '\r'; };
+
+    std::ptrdiff_t line = std::count(first, pos, '\n');
+
+    for (auto p = std::find(first, pos, '\r'); p != pos;
+         p = std::find(p + 1, pos, '\r')) {
+        if (p + 1 == pos || p[1] != '\n') {
+            ++line;
+        }
+    }
+
+    auto line_start = std::find_if(std::make_reverse_iterator(pos),
+                                   std::make_reverse_iterator(first),
+                                   is_line_break)
+                          .base();
+
+    return { static_cast<int>(line), static_cast<int>(pos - line_start) };
+}
+
+// Length of the UTF-8 sequence starting with `lead`, or 1 if invalid.
+inline int utf8_sequence_length(char8_t lead) noexcept
+{
+    if ((lead >> 5) == 0b110) {
+        return 2;
+    } else if ((lead >> 4) == 0b1110) {
+        return 3;
+    } else if ((lead >> 3) == 0b11110) {
+        return 4;
+    } else {
+        return 1;
+    }
+}
+
 // https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf#page=49
 inline bool unicode_is_noncharacter(char32_t value) noexcept
 {
@@ -138,6 +212,47 @@ inline bool read_utf8_char(I &&first, S &&last, char32_t &code_point)
     return true;
 }
 
+// Length of the UTF-8 sequence starting at `first` if it is non-ASCII, well
+// formed, and neither a surrogate nor a noncharacter, otherwise 0.
+inline int canonical_utf8_length(const char *first, const char *last) noexcept
+{
+    constexpr char32_t min_code_points[] = { 0, 0x80, 0x80, 0x800, 0x10000 };
+
+    const char *pos = first;
+    char32_t code_point;
+
+    if (!read_utf8_char(pos, last, code_point)) {
+        return 0;
+    }
+
+    auto length = pos - first;
+
+    if (code_point < min_code_points[length] || code_point > 0x10FFFF ||
+        unicode_is_surrogate(code_point) ||
+        unicode_is_noncharacter(code_point)) {
+        return 0;
+    }
+
+    return static_cast<int>(length);
+}
+
+// End of the longest prefix of `[first, last)` that needs neither escaping
+// nor re-encoding, and so can be copied as is.
+inline const char *find_verbatim_run(const char *first, const char *last)
+{
+    while ((first = find_string_special(first, last)) != last) {
+        int length = canonical_utf8_length(first, last);
+
+        if (!length) {
+            break;
+        }
+
+        first += length;
+    }
+
+    return first;
+}
+
 template <class O>
 inline void write_char8(O &&out, char8_t c)
 {
@@ -185,12 +300,15 @@ union PrimitiveValue {
     Bool bool_value;
     Int int_value;
     Float float_value;
+    const char *string_data;
 };
 
 template <class Alloc>
 class Primitive {
 public:
-    Primitive() noexcept(noexcept(Alloc())) : _alloc(), _value() {}
+    Primitive() noexcept(std::is_nothrow_default_constructible_v<Alloc>)
+        : _alloc(), _value()
+    {}
 
     explicit Primitive(const Alloc &alloc) noexcept : _alloc(alloc), _value() {}
 
@@ -296,6 +414,16 @@ public:
         return _value.float_value;
     }
 
+    auto &get_string_data() noexcept
+    {
+        return _value.string_data;
+    }
+
+    auto &get_string_data() const noexcept
+    {
+        return _value.string_data;
+    }
+
     void swap(Primitive &other) noexcept
     {
         if constexpr (std::allocator_traits<
@@ -311,6 +439,94 @@ private:
     PrimitiveValue _value;
 };
 
+// Converts 8 ASCII digits at once. See "Faster Integer Parsing" (Lemire;
+// https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits/).
+inline std::uint32_t parse_eight_digits(const char *p) noexcept
+{
+    std::uint64_t value =
+        load_unaligned_le64(reinterpret_cast<const unsigned char *>(p)) -
+        0x3030303030303030;
+
+    value = (value * 10) + (value >> 8);
+    value = (((value & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+             (((value >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+            32;
+
+    return static_cast<std::uint32_t>(value);
+}
+
+// Reads an optionally negative integer of at most 19 digits, which always
+// fits in 64 bits. Returns false for longer or out of range values.
+inline bool read_small_int(const char *first, const char *last, Int &value)
+{
+    bool negative = *first == '-';
+    first += negative;
+
+    if (last - first > 19) {
+        return false;
+    }
+
+    std::uint64_t result = 0;
+
+    for (; last - first >= 8; first += 8) {
+        result = result * 100000000 + parse_eight_digits(first);
+    }
+
+    for (; first != last; ++first) {
+        result = result * 10 + static_cast<unsigned>(*first - '0');
+    }
+
+    constexpr auto max = static_cast<std::uint64_t>(
+        std::numeric_limits<Int>::max());
+
+    if (result > max + negative) {
+        return false;
+    }
+
+    value = static_cast<Int>(negative ? 0 - result : result);
+    return true;
+}
+
+// Converts the text of a JSON integer, as kept by documents parsed with
+// `ParseOptions::lazy_numbers`, saturating values out of range.
+inline Int number_text_to_int(std::string_view text) noexcept
+{
+    const char *first = text.data();
+    const char *last = first + text.size();
+    Int value;
+
+    if (read_small_int(first, last, value) ||
+        std::from_chars(first, last, value).ec == std::errc()) {
+        return value;
+    }
+
+    return text[0] == '-' ? std::numeric_limits<Int>::min()
+                          : std::numeric_limits<Int>::max();
+}
+
+// Converts the text of any JSON number. Values out of range become infinite
+// if a positive exponent or a nonzero integer part makes them too large, and
+// zero otherwise.
+inline Float number_text_to_float(std::string_view text) noexcept
+{
+    const char *first = text.data();
+    const char *last = first + text.size();
+    Float value = 0;
+
+    if (std::from_chars(first, last, value).ec == std::errc()) {
+        return value;
+    }
+
+    bool negative = text[0] == '-';
+    std::size_t exponent = text.find_first_of("eE");
+    bool overflow = exponent != std::string_view::npos
+                        ? text[exponent + 1] != '-'
+                        : text[negative] != '0';
+
+    value = overflow ? std::numeric_limits<Float>::infinity() : 0.0;
+    return negative ? -value : value;
+}
+
 struct StringViewHash : std::hash<std::string_view> {
     using is_transparent = void;
 };
@@ -319,6 +535,58 @@ struct StringViewEqual : std::equal_to<std::string_view> {
     using is_transparent = void;
 };
 
+// String destination which writes over the input as it is read, for strings
+// unescaped in place. It never overtakes the input, as no character is longer
+// decoded than escaped.
+struct InSituString {
+    using value_type = char;
+
+    char *out;
+
+    void append(const char *value, std::size_t n) noexcept
+    {
+        if (value != out) {
+            std::memmove(out, value, n);
+        }
+
+        out += n;
+    }
+
+    void push_back(char c) noexcept
+    {
+        *out++ = c;
+    }
+};
+
+// String destination which discards its input, for strings that are only
+// validated.
+struct NullString {
+    using value_type = char;
+
+    void append(const char *, std::size_t) noexcept {}
+
+    void push_back(char) noexcept {}
+};
+
+// Hashes a string as it is read, with FNV-1a.
+struct HashString {
+    using value_type = char;
+
+    std::uint64_t value = 0xCBF29CE484222325;
+
+    void append(const char *s, std::size_t n) noexcept
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            push_back(s[i]);
+        }
+    }
+
+    void push_back(char c) noexcept
+    {
+        value = (value ^ static_cast<unsigned char>(c)) * 0x100000001B3;
+    }
+};
+
 template <class I, class S, class Alloc>
 struct ParseHandler {
     using Stack =
@@ -326,20 +594,45 @@ struct ParseHandler {
                     typename std::allocator_traits<Alloc>::rebind_alloc<
                         BasicDocument<Alloc> *>>;
 
+    // Contiguous input is only located once an error occurs, by scanning
+    // from `start`. Other input counts lines and columns as it is consumed.
+    static constexpr bool is_contiguous = contiguous_input<I, S>;
+
+    // Mutable characters are parsed in situ: strings are unescaped in place
+    // and borrowed by the document. As that overwrites the text already
+    // read, positions are counted as for non-contiguous input.
+    static constexpr bool is_in_situ = std::same_as<I, char *>;
+
+    static constexpr bool counts_position = !is_contiguous || is_in_situ;
+
+    using Start = std::conditional_t<is_contiguous, I, std::monostate>;
+
+    using KeyBuffer = std::basic_string<
+        char, std::char_traits<char>,
+        typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+
     I first;
     S last;
+    [[no_unique_address]] Start start;
     Stack stack;
     int line;
     int column;
+    std::ptrdiff_t offset;
     ParseErrorCode code;
     ParseOptions opts;
     [[no_unique_address]] Alloc alloc;
+    KeyBuffer key_buffer;
 
     ParseHandler(I first, S last, const Alloc &parser_alloc,
                  const Alloc &value_alloc, const ParseOptions &opts)
-        : first(std::move(first)), last(std::move(last)), stack(parser_alloc),
-          line(0), column(0), code(), opts(opts), alloc(value_alloc)
-    {}
+        : first(std::move(first)), last(std::move(last)), start(),
+          stack(parser_alloc), line(0), column(0), offset(0), code(), opts(opts),
+          alloc(value_alloc), key_buffer(parser_alloc)
+    {
+        if constexpr (is_contiguous) {
+            start = this->first;
+        }
+    }
 
     ParseResult<I, BasicDocument<Alloc>> parse()
     {
@@ -356,7 +649,24 @@ struct ParseHandler {
             continue_document(*stack.back());
         }
 
-        return { std::move(first), std::move(value), { code, line, column } };
+        locate_position();
+        return {
+            std::move(first),
+            std::move(value),
+            { code, line, column, offset },
+        };
+    }
+
+    // Fills in `line`, `column`, and `offset` of the current position.
+    void locate_position()
+    {
+        if constexpr (!counts_position) {
+            auto pos = locate(to_char_pointer(start), to_char_pointer(first));
+
+            line = pos.line;
+            column = pos.column;
+            offset = first - start;
+        }
     }
 
     bool has_error()
@@ -377,7 +687,11 @@ struct ParseHandler {
     void skip()
     {
         ++first;
-        ++column;
+
+        if constexpr (counts_position) {
+            ++column;
+            ++offset;
+        }
     }
 
     char next()
@@ -389,8 +703,10 @@ struct ParseHandler {
 
     void newline()
     {
-        ++line;
-        column = 0;
+        if constexpr (counts_position) {
+            ++line;
+            column = 0;
+        }
     }
 
     void expect_next(std::string_view s)
@@ -402,6 +718,38 @@ struct ParseHandler {
         }
     }
 
+    // Consumes the separator before the next element of a container, and
+    // returns whether there is one, consuming the closing bracket otherwise.
+    bool next_element(char close, bool empty)
+    {
+        if (consume_whitespace_and_comments()) {
+            return false;
+        } else if (peek() == close) {
+            skip();
+            return false;
+        } else if (empty) {
+            return true;
+        } else if (peek() != ',') {
+            set_unexpected_token();
+            return false;
+        }
+
+        skip();
+        if (consume_whitespace_and_comments()) {
+            return false;
+        } else if (peek() == close) {
+            if (opts.accept_trailing_commas) {
+                skip();
+            } else {
+                set_unexpected_token();
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
     void start_document(BasicDocument<Alloc> &dest)
     {
         if (consume_whitespace_and_comments()) {
@@ -420,7 +768,7 @@ struct ParseHandler {
             stack.push_back(std::addressof(dest));
             break;
         case '"':
-            read_string(dest.emplace_string());
+            read_string_value(dest);
             break;
         case '-':
         case '0':
@@ -478,6 +826,7 @@ struct ParseHandler {
             if (consume_whitespace_and_comments()) {
             } else if (peek() == ']') {
                 if (opts.accept_trailing_commas && dest.size()) {
+                    skip();
                     stack.pop_back();
                 } else {
                     set_unexpected_token();
@@ -529,7 +878,11 @@ struct ParseHandler {
             break;
 
         case '"':
-            start_entry(dest);
+            if (dest.size()) {
+                set_unexpected_token();
+            } else {
+                start_entry(dest);
+            }
             break;
 
         default:
@@ -562,71 +915,122 @@ struct ParseHandler {
 
     void read_number(BasicDocument<Alloc> &dest)
     {
-        using BufferAlloc =
-            typename std::allocator_traits<Alloc>::rebind_alloc<char>;
-        using BufferType =
-            std::basic_string<char, std::char_traits<char>, BufferAlloc>;
-
-        BufferType buf(BufferAlloc(stack.get_allocator()));
         bool is_int = true;
 
+        if constexpr (is_contiguous) {
+            const char *start = to_char_pointer(first);
+
+            if (!scan_number(is_int, [](char) {})) {
+                return;
+            } else if (opts.lazy_numbers) {
+                dest.emplace_borrowed_number(std::string_view(
+                    start, static_cast<std::size_t>(to_char_pointer(first) -
+                                                    start)));
+            } else {
+                convert_number(dest, start, to_char_pointer(first), is_int);
+            }
+        } else {
+            using BufferAlloc =
+                typename std::allocator_traits<Alloc>::rebind_alloc<char>;
+            using BufferType =
+                std::basic_string<char, std::char_traits<char>, BufferAlloc>;
+
+            // Only numbers longer than the stack buffer touch the allocator.
+            char buf[64];
+            std::size_t size = 0;
+            BufferType overflow(BufferAlloc(stack.get_allocator()));
+
+            auto append = [&](char c) {
+                if (size < sizeof(buf)) {
+                    buf[size++] = c;
+                } else {
+                    if (overflow.empty()) {
+                        overflow.assign(buf, size);
+                    }
+
+                    overflow.push_back(c);
+                }
+            };
+
+            if (!scan_number(is_int, append)) {
+                return;
+            } else if (overflow.empty()) {
+                convert_number(dest, buf, buf + size, is_int);
+            } else {
+                convert_number(dest, overflow.data(),
+                               overflow.data() + overflow.size(), is_int);
+            }
+        }
+    }
+
+    bool scan_number(bool &is_int, auto &&append)
+    {
         if (!done() && peek() == '-') {
-            buf.push_back(next());
+            append(next());
         }
 
         if (done() || !ascii_isdigit(peek())) {
             set_unexpected_token();
-            return;
+            return false;
         } else if (peek() == '0') {
-            buf.push_back(next());
+            append(next());
         } else {
             while (!done() && ascii_isdigit(peek())) {
-                buf.push_back(next());
+                append(next());
             }
         }
 
         if (!done() && peek() == '.') {
             is_int = false;
-            buf.push_back(next());
+            append(next());
 
             if (done() || !ascii_isdigit(peek())) {
                 set_unexpected_token();
-                return;
+                return false;
             }
 
             while (!done() && ascii_isdigit(peek())) {
-                buf.push_back(next());
+                append(next());
             }
         }
 
         if (!done() && (peek() == 'e' || peek() == 'E')) {
             is_int = false;
-            buf.push_back(next());
+            append(next());
 
             if (done()) {
                 set_unexpected_token();
-                return;
+                return false;
             } else if (peek() == '+' || peek() == '-') {
-                buf.push_back(next());
+                append(next());
             }
 
             if (done() || !ascii_isdigit(peek())) {
                 set_unexpected_token();
-                return;
+                return false;
             } else if (peek() == '0') {
-                buf.push_back(next());
+                append(next());
             } else {
                 while (!done() && ascii_isdigit(peek())) {
-                    buf.push_back(next());
+                    append(next());
                 }
             }
         }
 
-        const char *first = buf.data();
-        const char *last = first + buf.size();
+        return true;
+    }
+
+    void convert_number(BasicDocument<Alloc> &dest, const char *first,
+                        const char *last, bool is_int)
+    {
         std::from_chars_result result;
 
         if (is_int) {
+            if (Int value; read_small_int(first, last, value)) {
+                dest = value;
+                return;
+            }
+
             dest = 0;
             result = std::from_chars(first, last, dest.get_int());
         } else {
@@ -648,7 +1052,38 @@ struct ParseHandler {
         }
     }
 
-    void read_string(BasicString<Alloc> &dest)
+    // Checks the range of the number `[start, end)` without keeping it. Only
+    // numbers long enough to be out of range are converted.
+    void check_number(const char *start, const char *end, bool is_int)
+    {
+        std::size_t size = end - start;
+        bool has_exponent = std::find_if(start, end, [](char c) {
+                                return c == 'e' || c == 'E';
+                            }) != end;
+
+        if (is_int ? size > 18 : size > 300 || has_exponent) {
+            BasicDocument<Alloc> value(alloc);
+            convert_number(value, start, end, is_int);
+        }
+    }
+
+    void read_string_value(BasicDocument<Alloc> &dest)
+    {
+        if constexpr (is_in_situ) {
+            char *data = first + 1;
+            InSituString value{ data };
+
+            read_string(value);
+            if (!has_error()) {
+                dest.emplace_borrowed_string(
+                    { data, static_cast<std::size_t>(value.out - data) });
+            }
+        } else {
+            read_string(dest.emplace_string());
+        }
+    }
+
+    void read_string(auto &dest)
     {
         if (done() || peek() != '"') {
             set_unexpected_token();
@@ -656,11 +1091,23 @@ struct ParseHandler {
         }
 
         skip();
+        read_string_chars(dest);
+    }
+
+    // Reads the rest of a string after its opening quote.
+    void read_string_chars(auto &dest)
+    {
         for (char32_t code_point; !has_error();) {
-            if (done()) {
+            if constexpr (is_contiguous) {
+                append_string_run(dest);
+            }
+
+            if (done() || static_cast<unsigned char>(peek()) < 0x20) {
                 set_unexpected_token();
                 return;
-            } else if (!read_utf8_char(first, last, code_point)) {
+            }
+
+            if (!read_code_point(code_point)) {
                 set_invalid_encoding();
                 return;
             }
@@ -674,15 +1121,62 @@ struct ParseHandler {
                     while (read_escape(dest) && !has_error()) {
                     }
                 }
-            } else if (code_point < 0x20) {
-                set_unexpected_token();
             } else {
                 append_code_point(dest, code_point);
             }
         }
     }
 
-    bool read_escape(BasicString<Alloc> &dest)
+    // Appends the longest run of characters which need neither unescaping
+    // nor re-encoding in one copy.
+    void append_string_run(auto &dest)
+    {
+        const char *start = to_char_pointer(first);
+        const char *pos = find_string_run();
+
+        dest.append(start, pos - start);
+        first += pos - start;
+
+        if constexpr (counts_position) {
+            column += pos - start;
+            offset += pos - start;
+        }
+    }
+
+    const char *find_string_run()
+    {
+        const char *pos = to_char_pointer(first);
+        return find_verbatim_run(pos, pos + (last - first));
+    }
+
+    bool read_code_point(char32_t &code_point)
+    {
+        if constexpr (is_in_situ) {
+            auto prev = first;
+            bool valid = read_utf8_char(first, last, code_point);
+
+            column += first - prev;
+            offset += first - prev;
+            return valid;
+        } else if constexpr (is_contiguous) {
+            return read_utf8_char(first, last, code_point);
+        } else {
+            // Buffer the sequence so that every byte consumed is counted.
+            char8_t buf[4];
+            int length = utf8_sequence_length(peek());
+            int size = 0;
+
+            buf[size++] = next();
+            while (size < length && !done() && (peek() & 0xC0) == 0x80) {
+                buf[size++] = next();
+            }
+
+            const char8_t *p = buf;
+            return read_utf8_char(p, buf + size, code_point);
+        }
+    }
+
+    bool read_escape(auto &dest)
     {
         // std::cout << "read_escape(): " << std::to_address(first)
         //           << ", peek(): " << peek() << "\n";
@@ -728,7 +1222,7 @@ struct ParseHandler {
         return false;
     }
 
-    bool read_unicode_escape(BasicString<Alloc> &dest)
+    bool read_unicode_escape(auto &dest)
     {
         char32_t code_point = read_unicode_escape_hex();
 
@@ -743,7 +1237,7 @@ struct ParseHandler {
         return false;
     }
 
-    bool read_low_surrogate(BasicString<Alloc> &dest, char16_t high)
+    bool read_low_surrogate(auto &dest, char16_t high)
     {
         if (done()) {
             set_unexpected_token();
@@ -777,7 +1271,7 @@ struct ParseHandler {
         return false;
     }
 
-    void append_code_point(BasicString<Alloc> &dest, char32_t code_point)
+    void append_code_point(auto &dest, char32_t code_point)
     {
         if (unicode_is_surrogate(code_point) ||
             unicode_is_noncharacter(code_point)) {
@@ -841,8 +1335,8 @@ struct ParseHandler {
                 break;
 
             case '\n':
-                newline();
                 skip();
+                newline();
                 break;
 
             case '\t':
@@ -897,6 +1391,7 @@ struct ParseHandler {
             case '*':
                 skip();
                 if (!single && !done() && peek() == '/') {
+                    skip();
                     return;
                 }
                 break;
@@ -928,6 +1423,11 @@ struct ParseHandler {
         code = ParseErrorCode::NumberOutOfRange;
     }
 
+    void set_aborted()
+    {
+        code = ParseErrorCode::Aborted;
+    }
+
     void set_duplicate_key()
     {
         code = ParseErrorCode::DuplicateKey;
@@ -937,15 +1437,1926 @@ struct ParseHandler {
     {
         code = ParseErrorCode::InvalidEncoding;
     }
+
+    void set_type_mismatch()
+    {
+        code = ParseErrorCode::TypeMismatch;
+    }
 };
 
+// Parses contiguous input in two stages. The first stage builds an index of
+// the structural characters with `build_structural_index`, and the second
+// builds the document by walking that index, decoding scalars with a
+// `ParseHandler`. Any input this handler cannot accept is left for the
+// `ParseHandler` to parse again, so that errors are reported identically.
 template <class Alloc>
-struct SerializePosition {
-    using DocumentType = BasicDocument<Alloc>;
-    using ArrayType = BasicArray<Alloc>;
-    using ObjectType = BasicObject<Alloc>;
-    using ArrayIt = ArrayType::const_iterator;
-    using ObjectIt = ObjectType::const_iterator;
+struct IndexParseHandler {
+    using Index =
+        std::vector<std::uint32_t, typename std::allocator_traits<
+                                       Alloc>::rebind_alloc<std::uint32_t>>;
+
+    using Reader = ParseHandler<const char *, const char *, Alloc>;
+
+    const char *first;
+    const char *last;
+    const char *end;
+    Index index;
+    Index sizes;
+    std::size_t index_pos;
+    std::size_t size_pos;
+    Reader reader;
+
+    IndexParseHandler(const char *first, const char *last,
+                      const Alloc &parser_alloc, const Alloc &value_alloc,
+                      const ParseOptions &opts)
+        : first(first), last(last), end(first), index(parser_alloc),
+          sizes(parser_alloc), index_pos(0), size_pos(0),
+          reader(first, last, parser_alloc, value_alloc, opts)
+    {}
+
+    static std::optional<ParseResult<const char *, BasicDocument<Alloc>>>
+    parse(const char *first, const char *last, const Alloc &parser_alloc,
+          const Alloc &value_alloc, const ParseOptions &opts)
+    {
+        IndexParseHandler handler(
+            first, last, parser_alloc, value_alloc, opts);
+        BasicDocument<Alloc> value(value_alloc);
+
+        if (!handler.parse(value)) {
+            return std::nullopt;
+        }
+
+        auto pos = locate(first, handler.end);
+
+        return ParseResult<const char *, BasicDocument<Alloc>>{
+            handler.end,
+            std::move(value),
+            { ParseErrorCode(), pos.line, pos.column, handler.end - first },
+        };
+    }
+
+    bool parse(BasicDocument<Alloc> &dest)
+    {
+        if (reader.opts.accept_comments ||
+            last - first > std::numeric_limits<std::uint32_t>::max()) {
+            return false;
+        }
+
+        build_structural_index(first, last, index);
+        count_elements();
+
+        if (!start_document(dest)) {
+            return false;
+        }
+
+        while (reader.stack.size()) {
+            if (reader.stack.size() > reader.opts.max_depth ||
+                !continue_document(*reader.stack.back())) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Counts the elements of each container, in document order, so their
+    // storage can be reserved up front. Only a hint for invalid input.
+    void count_elements()
+    {
+        Index open(index.get_allocator());
+        char prev = 0;
+
+        for (auto offset: index) {
+            char c = first[offset];
+
+            switch (c) {
+            case '[':
+            case '{':
+                open.push_back(sizes.size());
+                sizes.push_back(0);
+                break;
+            case ']':
+            case '}':
+                if (open.size()) {
+                    auto &size = sizes[open.back()];
+                    size = (prev == '[' || prev == '{') ? 0 : size + 1;
+                    open.pop_back();
+                }
+                break;
+            case ',':
+                if (open.size()) {
+                    ++sizes[open.back()];
+                }
+                break;
+            }
+
+            prev = c;
+        }
+    }
+
+    std::size_t next_size()
+    {
+        return size_pos < sizes.size() ? sizes[size_pos++] : 0;
+    }
+
+    bool done()
+    {
+        return index_pos == index.size();
+    }
+
+    const char *token()
+    {
+        return first + index[index_pos];
+    }
+
+    // Checks that only whitespace is between `pos` and the next token.
+    bool expect_token(const char *pos)
+    {
+        const char *next = done() ? last : token();
+        return pos <= next && std::all_of(pos, next, is_json_whitespace);
+    }
+
+    bool start_document(BasicDocument<Alloc> &dest)
+    {
+        if (done()) {
+            return false;
+        }
+
+        const char *pos = token();
+        ++index_pos;
+
+        switch (*pos) {
+        case '{':
+            if (auto size = next_size()) {
+                dest.emplace_object().reserve(size);
+            } else {
+                dest.emplace_object();
+            }
+
+            reader.stack.push_back(std::addressof(dest));
+            end = pos + 1;
+            return true;
+        case '[':
+            dest.emplace_array().reserve(next_size());
+            reader.stack.push_back(std::addressof(dest));
+            end = pos + 1;
+            return true;
+        case '"':
+            reader.first = pos;
+            reader.read_string(dest.emplace_string());
+            return end_scalar();
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            reader.first = pos;
+            reader.read_number(dest);
+            return end_scalar();
+        case 't':
+            dest = true;
+            return read_literal(pos, "true");
+        case 'f':
+            dest = false;
+            return read_literal(pos, "false");
+        case 'n':
+            dest = nullptr;
+            return read_literal(pos, "null");
+        default:
+            return false;
+        }
+    }
+
+    bool read_literal(const char *pos, std::string_view literal)
+    {
+        if (static_cast<std::size_t>(last - pos) < literal.size() ||
+            literal.compare(0, literal.size(), pos, literal.size())) {
+            return false;
+        }
+
+        reader.first = pos + literal.size();
+        return end_scalar();
+    }
+
+    bool end_scalar()
+    {
+        if (reader.has_error() ||
+            (reader.stack.size() && !expect_token(reader.first))) {
+            return false;
+        }
+
+        end = reader.first;
+        return true;
+    }
+
+    bool continue_document(BasicDocument<Alloc> &dest)
+    {
+        if (dest.is_array()) {
+            return continue_array(dest.get_array());
+        } else {
+            return continue_object(dest.get_object());
+        }
+    }
+
+    bool continue_array(BasicArray<Alloc> &dest)
+    {
+        if (done()) {
+            return false;
+        }
+
+        switch (*token()) {
+        case ']':
+            end = token() + 1;
+            ++index_pos;
+            reader.stack.pop_back();
+            return true;
+        case ',':
+            ++index_pos;
+            if (done()) {
+                return false;
+            } else if (*token() == ']') {
+                if (!reader.opts.accept_trailing_commas || dest.empty()) {
+                    return false;
+                }
+
+                end = token() + 1;
+                ++index_pos;
+                reader.stack.pop_back();
+                return true;
+            } else if (dest.empty()) {
+                return false;
+            }
+
+            return start_document(dest.emplace_back());
+        default:
+            if (dest.size()) {
+                return false;
+            }
+
+            return start_document(dest.emplace_back());
+        }
+    }
+
+    bool continue_object(BasicObject<Alloc> &dest)
+    {
+        if (done()) {
+            return false;
+        }
+
+        switch (*token()) {
+        case '}':
+            end = token() + 1;
+            ++index_pos;
+            reader.stack.pop_back();
+            return true;
+        case ',':
+            ++index_pos;
+            if (dest.empty() || done()) {
+                return false;
+            } else if (*token() == '}') {
+                if (!reader.opts.accept_trailing_commas) {
+                    return false;
+                }
+
+                end = token() + 1;
+                ++index_pos;
+                reader.stack.pop_back();
+                return true;
+            }
+
+            return start_entry(dest);
+        case '"':
+            return dest.empty() && start_entry(dest);
+        default:
+            return false;
+        }
+    }
+
+    bool start_entry(BasicObject<Alloc> &dest)
+    {
+        if (done() || *token() != '"') {
+            return false;
+        }
+
+        Alloc alloc(dest.get_allocator());
+        BasicString<Alloc> key(alloc);
+
+        reader.first = token();
+        ++index_pos;
+        reader.read_string(key);
+
+        if (reader.has_error() || !expect_token(reader.first) || done() ||
+            *token() != ':') {
+            return false;
+        }
+
+        ++index_pos;
+
+        auto [pos, inserted] = dest.try_emplace(std::move(key), alloc);
+        if (!reader.opts.accept_duplicate_keys && !inserted) {
+            return false;
+        }
+
+        return start_document(pos->second);
+    }
+};
+
+// Parses input into calls to the members of `H`, without building a
+// document. Handlers need only define the callbacks they use, and stop the
+// parse by returning false from any of them.
+template <class I, class S, class Alloc, class H>
+struct EventParseHandler {
+    struct Frame {
+        bool is_object;
+        bool empty;
+    };
+
+    using Reader = ParseHandler<I, S, Alloc>;
+    using Stack = std::vector<
+        Frame, typename std::allocator_traits<Alloc>::rebind_alloc<Frame>>;
+
+    Reader reader;
+    Stack stack;
+    BasicString<Alloc> buffer;
+    BasicDocument<Alloc> number;
+    H &handler;
+
+    EventParseHandler(I first, S last, H &handler, const Alloc &alloc,
+                      const ParseOptions &opts)
+        : reader(std::move(first), std::move(last), alloc, alloc, opts),
+          stack(alloc), buffer(alloc), number(alloc), handler(handler)
+    {
+        // Numbers are passed on as soon as they are read, so are converted.
+        reader.opts.lazy_numbers = false;
+    }
+
+    ParseEventsResult<I> parse()
+    {
+        start_value();
+
+        while (!reader.has_error() && stack.size()) {
+            if (stack.size() > reader.opts.max_depth) {
+                reader.set_max_depth();
+                break;
+            }
+
+            if (stack.back().is_object) {
+                continue_object();
+            } else {
+                continue_array();
+            }
+        }
+
+        reader.locate_position();
+        return {
+            std::move(reader.first),
+            { reader.code, reader.line, reader.column, reader.offset },
+        };
+    }
+
+    // Invokes a callback, which aborts the parse if it returns false.
+    void notify(auto &&callback)
+    {
+        if constexpr (std::same_as<decltype(callback()), bool>) {
+            if (!callback()) {
+                reader.set_aborted();
+            }
+        } else {
+            callback();
+        }
+    }
+
+    void start_value()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case '{':
+            reader.skip();
+            stack.push_back({ true, true });
+            if constexpr (requires { handler.on_start_object(); }) {
+                notify([&] { return handler.on_start_object(); });
+            }
+            break;
+        case '[':
+            reader.skip();
+            stack.push_back({ false, true });
+            if constexpr (requires { handler.on_start_array(); }) {
+                notify([&] { return handler.on_start_array(); });
+            }
+            break;
+        case '"':
+            if (std::string_view value; read_string(value)) {
+                if constexpr (requires { handler.on_string(value); }) {
+                    notify([&] { return handler.on_string(value); });
+                }
+            }
+            break;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            read_number();
+            break;
+        case 't':
+            read_bool("true", true);
+            break;
+        case 'f':
+            read_bool("false", false);
+            break;
+        case 'n':
+            reader.expect_next("null");
+            if constexpr (requires { handler.on_null(); }) {
+                if (!reader.has_error()) {
+                    notify([&] { return handler.on_null(); });
+                }
+            }
+            break;
+        default:
+            reader.set_unexpected_token();
+            break;
+        }
+    }
+
+    void read_bool(std::string_view literal, bool value)
+    {
+        reader.expect_next(literal);
+        if constexpr (requires { handler.on_bool(value); }) {
+            if (!reader.has_error()) {
+                notify([&] { return handler.on_bool(value); });
+            }
+        }
+    }
+
+    void read_number()
+    {
+        reader.read_number(number);
+
+        if (reader.has_error()) {
+            return;
+        } else if (number.is_int()) {
+            if constexpr (requires { handler.on_int(Int()); }) {
+                notify([&] { return handler.on_int(number.get_int()); });
+            }
+        } else {
+            if constexpr (requires { handler.on_float(Float()); }) {
+                notify([&] { return handler.on_float(number.get_float()); });
+            }
+        }
+    }
+
+    // Strings without escapes are viewed in place when the input is
+    // contiguous, others are decoded into `buffer`.
+    bool read_string(std::string_view &dest)
+    {
+        if (reader.done() || reader.peek() != '"') {
+            reader.set_unexpected_token();
+            return false;
+        }
+
+        reader.skip();
+        buffer.clear();
+
+        if constexpr (Reader::is_contiguous) {
+            const char *start = to_char_pointer(reader.first);
+            const char *pos = reader.find_string_run();
+
+            reader.first += pos - start;
+            if (!reader.done() && reader.peek() == '"') {
+                reader.skip();
+                dest = std::string_view(start, pos - start);
+                return true;
+            }
+
+            buffer.append(start, pos - start);
+        }
+
+        reader.read_string_chars(buffer);
+        dest = buffer;
+        return !reader.has_error();
+    }
+
+    void end_container()
+    {
+        bool is_object = stack.back().is_object;
+
+        reader.skip();
+        stack.pop_back();
+
+        if (is_object) {
+            if constexpr (requires { handler.on_end_object(); }) {
+                notify([&] { return handler.on_end_object(); });
+            }
+        } else {
+            if constexpr (requires { handler.on_end_array(); }) {
+                notify([&] { return handler.on_end_array(); });
+            }
+        }
+    }
+
+    void continue_array()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        Frame &frame = stack.back();
+
+        switch (reader.peek()) {
+        case ']':
+            end_container();
+            break;
+        case ',':
+            reader.skip();
+            if (reader.consume_whitespace_and_comments()) {
+            } else if (reader.peek() == ']') {
+                if (reader.opts.accept_trailing_commas && !frame.empty) {
+                    end_container();
+                } else {
+                    reader.set_unexpected_token();
+                }
+            } else if (frame.empty) {
+                reader.set_unexpected_token();
+            } else {
+                start_value();
+            }
+            break;
+        default:
+            if (!frame.empty) {
+                reader.set_unexpected_token();
+            } else {
+                frame.empty = false;
+                start_value();
+            }
+            break;
+        }
+    }
+
+    void continue_object()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        Frame &frame = stack.back();
+
+        switch (reader.peek()) {
+        case '}':
+            end_container();
+            break;
+        case ',':
+            reader.skip();
+            if (frame.empty) {
+                reader.set_unexpected_token();
+            } else if (reader.consume_whitespace_and_comments()) {
+            } else if (reader.peek() == '}') {
+                if (reader.opts.accept_trailing_commas) {
+                    end_container();
+                } else {
+                    reader.set_unexpected_token();
+                }
+            } else {
+                start_entry();
+            }
+            break;
+        case '"':
+            if (!frame.empty) {
+                reader.set_unexpected_token();
+            } else {
+                frame.empty = false;
+                start_entry();
+            }
+            break;
+        default:
+            reader.set_unexpected_token();
+            break;
+        }
+    }
+
+    // Duplicate keys are not detected, as that would need every key kept.
+    void start_entry()
+    {
+        std::string_view key;
+
+        if (!read_string(key) || reader.consume_whitespace_and_comments()) {
+            return;
+        } else if (reader.next() != ':') {
+            reader.set_unexpected_token();
+            return;
+        }
+
+        if constexpr (requires { handler.on_key(key); }) {
+            notify([&] { return handler.on_key(key); });
+        }
+
+        if (!reader.has_error()) {
+            start_value();
+        }
+    }
+};
+
+// Stack of single bits which only allocates past its inline capacity.
+template <class Alloc>
+class BitStack {
+private:
+    static constexpr std::size_t inline_size = 4;
+
+    using Words = std::vector<
+        std::uint64_t,
+        typename std::allocator_traits<Alloc>::rebind_alloc<std::uint64_t>>;
+
+    std::uint64_t _inline[inline_size];
+    Words _words;
+    std::size_t _size;
+
+    std::uint64_t &_word(std::size_t n)
+    {
+        return n < inline_size ? _inline[n] : _words[n - inline_size];
+    }
+
+public:
+    explicit BitStack(const Alloc &alloc) : _inline(), _words(alloc), _size(0)
+    {}
+
+    std::size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    bool back()
+    {
+        return (_word((_size - 1) / 64) >> ((_size - 1) % 64)) & 1;
+    }
+
+    void push_back(bool value)
+    {
+        if (_size / 64 >= inline_size && _size % 64 == 0) {
+            _words.push_back(0);
+        }
+
+        std::uint64_t &word = _word(_size / 64);
+        std::uint64_t bit = std::uint64_t(1) << (_size % 64);
+
+        word = value ? word | bit : word & ~bit;
+        ++_size;
+    }
+
+    void pop_back() noexcept
+    {
+        if (--_size / 64 >= inline_size && _size % 64 == 0) {
+            _words.pop_back();
+        }
+    }
+};
+
+// Keys of the open objects, for finding duplicates without building the
+// objects. Keys are decoded one after another into a shared buffer. Small
+// objects are searched in place, and the keys of larger ones are indexed by
+// text and by object in a hash set.
+template <class Alloc>
+class KeyStack {
+public:
+    using Buffer = std::basic_string<
+        char, std::char_traits<char>,
+        typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+
+    explicit KeyStack(const Alloc &alloc)
+        : _text(alloc), _keys(alloc), _objects(alloc),
+          _set(0, Hash{ this }, Equal{ this }, alloc), _pending(0)
+    {}
+
+    KeyStack(const KeyStack &) = delete;
+
+    KeyStack &operator=(const KeyStack &) = delete;
+
+    void push_object()
+    {
+        _objects.push_back(_keys.size());
+    }
+
+    void pop_object()
+    {
+        std::size_t start = _objects.back();
+
+        if (_keys.size() - start >= linear_size) {
+            for (std::size_t i = start; i < _keys.size(); ++i) {
+                _set.erase(i);
+            }
+        }
+
+        if (start < _keys.size()) {
+            _text.resize(_keys[start].offset);
+        }
+
+        _keys.resize(start);
+        _objects.pop_back();
+    }
+
+    // Buffer to read the next key of the innermost object into, which
+    // `insert` then adds.
+    Buffer &next_key()
+    {
+        _pending = _text.size();
+        return _text;
+    }
+
+    // Adds the key read since `next_key`, or returns false if the innermost
+    // object already has it.
+    bool insert()
+    {
+        std::size_t start = _objects.back();
+        std::size_t count = _keys.size() - start;
+
+        _keys.push_back({ _pending, _text.size() - _pending, _objects.size() });
+
+        if (count < linear_size) {
+            std::string_view key = _view(count + start);
+
+            for (std::size_t i = start; i < start + count; ++i) {
+                if (_view(i) == key) {
+                    return _remove_last();
+                }
+            }
+
+            if (count + 1 == linear_size) {
+                for (std::size_t i = start; i <= start + count; ++i) {
+                    _set.insert(i);
+                }
+            }
+        } else if (!_set.insert(_keys.size() - 1).second) {
+            return _remove_last();
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr std::size_t linear_size = 16;
+
+    struct Key {
+        std::size_t offset;
+        std::size_t size;
+        std::size_t object;
+    };
+
+    struct Hash {
+        const KeyStack *keys;
+
+        std::size_t operator()(std::size_t i) const noexcept
+        {
+            return std::hash<std::string_view>()(keys->_view(i)) ^
+                   keys->_keys[i].object * 0x9E3779B97F4A7C15;
+        }
+    };
+
+    struct Equal {
+        const KeyStack *keys;
+
+        bool operator()(std::size_t a, std::size_t b) const noexcept
+        {
+            return keys->_keys[a].object == keys->_keys[b].object &&
+                   keys->_view(a) == keys->_view(b);
+        }
+    };
+
+    template <class T>
+    using Vector =
+        std::vector<T, typename std::allocator_traits<Alloc>::rebind_alloc<T>>;
+
+    Buffer _text;
+    Vector<Key> _keys;
+    Vector<std::size_t> _objects;
+    std::unordered_set<
+        std::size_t, Hash, Equal,
+        typename std::allocator_traits<Alloc>::rebind_alloc<std::size_t>>
+        _set;
+    std::size_t _pending;
+
+    std::string_view _view(std::size_t i) const noexcept
+    {
+        return { _text.data() + _keys[i].offset, _keys[i].size };
+    }
+
+    bool _remove_last()
+    {
+        _keys.pop_back();
+        _text.resize(_pending);
+        return false;
+    }
+};
+
+// Checks that the input holds a document without building one. Strings are
+// only scanned and numbers only converted to check their range. Errors are
+// the same as those of `ParseHandler`. Unless duplicate keys are accepted,
+// the keys of open objects are kept to find them.
+template <class I, class S, class Alloc>
+struct ValidateHandler {
+    using Reader = ParseHandler<I, S, Alloc>;
+
+    Reader reader;
+    BasicDocument<Alloc> number;
+
+    // Open containers, set for objects, and whether the innermost has no
+    // elements yet.
+    BitStack<Alloc> stack;
+    bool empty;
+    KeyStack<Alloc> keys;
+
+    ValidateHandler(I first, S last, const Alloc &alloc,
+                    const ParseOptions &opts)
+        : reader(std::move(first), std::move(last), alloc, alloc, opts),
+          number(alloc), stack(alloc), empty(false), keys(alloc)
+    {
+        // Converting numbers is what checks their range.
+        reader.opts.lazy_numbers = false;
+    }
+
+    ParseEventsResult<I> validate()
+    {
+        start_value();
+
+        while (!reader.has_error() && stack.size()) {
+            if (stack.size() > reader.opts.max_depth) {
+                reader.set_max_depth();
+                break;
+            }
+
+            if (stack.back()) {
+                continue_object();
+            } else {
+                continue_array();
+            }
+        }
+
+        reader.locate_position();
+        return {
+            std::move(reader.first),
+            { reader.code, reader.line, reader.column, reader.offset },
+        };
+    }
+
+    void start_value()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case '{':
+        case '[':
+            open_container(reader.next() == '{');
+            break;
+        case '"': {
+            NullString value;
+
+            reader.read_string(value);
+            break;
+        }
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            reader.read_number(number);
+            break;
+        case 't':
+            reader.expect_next("true");
+            break;
+        case 'f':
+            reader.expect_next("false");
+            break;
+        case 'n':
+            reader.expect_next("null");
+            break;
+        default:
+            reader.set_unexpected_token();
+            break;
+        }
+    }
+
+    bool checks_keys() const noexcept
+    {
+        return !reader.opts.accept_duplicate_keys;
+    }
+
+    void open_container(bool is_object)
+    {
+        if (is_object && checks_keys()) {
+            keys.push_object();
+        }
+
+        stack.push_back(is_object);
+        empty = true;
+    }
+
+    void end_container()
+    {
+        if (stack.back() && checks_keys()) {
+            keys.pop_object();
+        }
+
+        reader.skip();
+        stack.pop_back();
+        empty = false;
+    }
+
+    void continue_array()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case ']':
+            end_container();
+            break;
+        case ',':
+            reader.skip();
+            if (reader.consume_whitespace_and_comments()) {
+            } else if (reader.peek() == ']') {
+                if (reader.opts.accept_trailing_commas && !empty) {
+                    end_container();
+                } else {
+                    reader.set_unexpected_token();
+                }
+            } else if (empty) {
+                reader.set_unexpected_token();
+            } else {
+                start_value();
+            }
+            break;
+        default:
+            if (!empty) {
+                reader.set_unexpected_token();
+            } else {
+                empty = false;
+                start_value();
+            }
+            break;
+        }
+    }
+
+    void continue_object()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case '}':
+            end_container();
+            break;
+        case ',':
+            reader.skip();
+            if (empty) {
+                reader.set_unexpected_token();
+            } else if (reader.consume_whitespace_and_comments()) {
+            } else if (reader.peek() == '}') {
+                if (reader.opts.accept_trailing_commas) {
+                    end_container();
+                } else {
+                    reader.set_unexpected_token();
+                }
+            } else {
+                start_entry();
+            }
+            break;
+        case '"':
+            if (!empty) {
+                reader.set_unexpected_token();
+            } else {
+                empty = false;
+                start_entry();
+            }
+            break;
+        default:
+            reader.set_unexpected_token();
+            break;
+        }
+    }
+
+    void start_entry()
+    {
+        if (checks_keys()) {
+            reader.read_string(keys.next_key());
+        } else {
+            NullString key;
+
+            reader.read_string(key);
+        }
+
+        if (reader.has_error() || reader.consume_whitespace_and_comments()) {
+            return;
+        } else if (reader.next() != ':') {
+            reader.set_unexpected_token();
+            return;
+        } else if (checks_keys() && !keys.insert()) {
+            reader.set_duplicate_key();
+            return;
+        }
+
+        start_value();
+    }
+};
+
+// Fingerprints of the keys of the open objects, for finding duplicate keys in
+// a fixed amount of memory. Keys are hashed once decoded, so equal keys always
+// clash, and `insert` fails for them. As distinct keys may clash as well, and
+// `insert` also fails once the table is full, the caller must then check the
+// input again with the keys themselves.
+class KeyTable {
+public:
+    // Adds a key of the innermost object, at `depth`, unless it is full or
+    // that object has a key with the same fingerprint.
+    bool insert(std::uint64_t hash, std::size_t depth) noexcept
+    {
+        if (_size == max_size) {
+            return false;
+        }
+
+        std::uint64_t fingerprint = (hash ^ depth * 0x9E3779B97F4A7C15) | 1;
+        std::size_t i = _home(fingerprint);
+
+        for (; _slots[i]; i = (i + 1) % table_size) {
+            if (_slots[i] == fingerprint) {
+                return false;
+            }
+        }
+
+        _slots[i] = fingerprint;
+        _keys[_size++] = { fingerprint, depth };
+        return true;
+    }
+
+    // Removes the keys of the innermost object, at `depth`.
+    void pop_object(std::size_t depth) noexcept
+    {
+        for (; _size && _keys[_size - 1].depth == depth; --_size) {
+            _erase(_keys[_size - 1].fingerprint);
+        }
+    }
+
+private:
+    static constexpr std::size_t table_size = 512;
+    static constexpr std::size_t max_size = table_size / 2;
+
+    struct Key {
+        std::uint64_t fingerprint;
+        std::size_t depth;
+    };
+
+    std::uint64_t _slots[table_size] = {};
+    Key _keys[max_size];
+    std::size_t _size = 0;
+
+    static std::size_t _home(std::uint64_t fingerprint) noexcept
+    {
+        return (fingerprint * 0x9E3779B97F4A7C15) >>
+               (64 - std::countr_zero(table_size));
+    }
+
+    // Linear probing removal, which moves later entries of the probe
+    // sequence back into the gap instead of leaving a marker.
+    void _erase(std::uint64_t fingerprint) noexcept
+    {
+        std::size_t i = _home(fingerprint);
+
+        while (_slots[i] != fingerprint) {
+            i = (i + 1) % table_size;
+        }
+
+        for (std::size_t j = (i + 1) % table_size; _slots[j];
+             j = (j + 1) % table_size) {
+            std::size_t home = _home(_slots[j]);
+
+            if ((j - home) % table_size >= (j - i) % table_size) {
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+
+        _slots[i] = 0;
+    }
+};
+
+// Validates contiguous input in one pass over its 64 byte blocks. Each block
+// is classified with SIMD, and checked as a whole for UTF-8 with
+// `Utf8Checker` and for control characters and escapes within strings with
+// the masks of `StructuralScanner`. Its structural characters then drive the
+// grammar, so the contents of strings are not read again. Object keys are
+// kept as fingerprints in a `KeyTable`. Below the inline depth of `BitStack`,
+// nothing is allocated.
+//
+// Input this handler cannot accept, including possible duplicate keys and
+// objects too large to keep the keys of, is left for `ValidateHandler` to
+// check again, so that errors are reported identically.
+template <class Alloc>
+struct BlockValidateHandler {
+    using Reader = ParseHandler<const char *, const char *, Alloc>;
+
+    // What the next structural character may be.
+    enum class State {
+        Value,
+        FirstElement,
+        Element,
+        FirstKey,
+        Key,
+        Colon,
+        Next,
+        Done,
+    };
+
+    const char *first;
+    const char *last;
+    const char *end;
+    const char *escapes_end;
+    Reader reader;
+    BitStack<Alloc> stack;
+    State state;
+    KeyTable keys;
+
+    BlockValidateHandler(const char *first, const char *last,
+                         const Alloc &alloc, const ParseOptions &opts)
+        : first(first), last(last), end(first), escapes_end(first),
+          reader(first, last, alloc, alloc, opts), stack(alloc),
+          state(State::Value), keys()
+    {}
+
+    bool validate()
+    {
+        const char *pos = std::find_if_not(first, last, is_json_whitespace);
+
+        // Scalar documents are read as fast by `ValidateHandler`.
+        if (reader.opts.accept_comments || pos == last ||
+            (*pos != '{' && *pos != '[')) {
+            return false;
+        }
+
+        StructuralScanner scanner;
+        Utf8Checker utf8;
+        std::size_t size = last - first;
+        std::size_t offset = 0;
+
+        for (; size - offset >= simd_block_size && state != State::Done;
+             offset += simd_block_size) {
+            const char *block = first + offset;
+
+            if (scanner.in_string() &&
+                find_string_special(block, block + simd_block_size) ==
+                    block + simd_block_size) {
+                utf8.next(block);
+            } else if (!scan(scanner, utf8, offset, block)) {
+                return false;
+            }
+        }
+
+        if (offset != size && state != State::Done) {
+            char block[simd_block_size];
+
+            std::memset(block, ' ', simd_block_size);
+            std::memcpy(block, first + offset, size - offset);
+            if (!scan(scanner, utf8, offset, block)) {
+                return false;
+            }
+        }
+
+        return state == State::Done && utf8.valid();
+    }
+
+    bool scan(StructuralScanner &scanner, Utf8Checker &utf8,
+              std::size_t offset, const char *block)
+    {
+        BlockMasks masks = classify_block(block);
+        std::uint64_t bits = scanner.next(masks);
+        std::uint64_t strings = scanner.string_tail();
+
+        utf8.next(block);
+
+        if ((masks.control & strings) ||
+            !check_escapes(offset, scanner.escaped() & strings)) {
+            return false;
+        }
+
+        for (; bits && state != State::Done; bits &= bits - 1) {
+            if (!next_token(first + offset + std::countr_zero(bits))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Checks the escapes of a block, given the characters which follow
+    // their backslashes.
+    bool check_escapes(std::size_t offset, std::uint64_t escaped)
+    {
+        NullString value;
+
+        for (; escaped; escaped &= escaped - 1) {
+            const char *pos = first + offset + std::countr_zero(escaped);
+
+            // Low surrogates are read with the escape before them.
+            if (pos < escapes_end) {
+                continue;
+            }
+
+            reader.first = pos;
+            while (reader.read_escape(value) && !reader.has_error()) {
+            }
+
+            if (reader.has_error()) {
+                return false;
+            }
+
+            escapes_end = reader.first;
+        }
+
+        return true;
+    }
+
+    bool checks_keys() const noexcept
+    {
+        return !reader.opts.accept_duplicate_keys;
+    }
+
+    bool next_token(const char *pos)
+    {
+        switch (state) {
+        case State::Value:
+            return start_value(pos);
+        case State::FirstElement:
+            return *pos == ']' ? end_container(pos) : start_value(pos);
+        case State::Element:
+            if (*pos == ']') {
+                return reader.opts.accept_trailing_commas &&
+                       end_container(pos);
+            }
+
+            return start_value(pos);
+        case State::FirstKey:
+            return *pos == '}' ? end_container(pos) : start_key(pos);
+        case State::Key:
+            if (*pos == '}') {
+                return reader.opts.accept_trailing_commas &&
+                       end_container(pos);
+            }
+
+            return start_key(pos);
+        case State::Colon:
+            state = State::Value;
+            return *pos == ':';
+        case State::Next:
+            switch (*pos) {
+            case ',':
+                state = stack.back() ? State::Key : State::Element;
+                return true;
+            case ']':
+                return !stack.back() && end_container(pos);
+            case '}':
+                return stack.back() && end_container(pos);
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    }
+
+    bool start_value(const char *pos)
+    {
+        switch (*pos) {
+        case '{':
+        case '[':
+            stack.push_back(*pos == '{');
+            state = *pos == '{' ? State::FirstKey : State::FirstElement;
+            return stack.size() <= reader.opts.max_depth;
+        case '"':
+            state = State::Next;
+            return true;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+            bool is_int = true;
+
+            reader.first = pos;
+            if (!reader.scan_number(is_int, [](char) {})) {
+                return false;
+            }
+
+            reader.check_number(pos, reader.first, is_int);
+            return !reader.has_error() && end_scalar();
+        }
+        case 't':
+            return read_literal(pos, "true");
+        case 'f':
+            return read_literal(pos, "false");
+        case 'n':
+            return read_literal(pos, "null");
+        default:
+            return false;
+        }
+    }
+
+    bool read_literal(const char *pos, std::string_view literal)
+    {
+        if (static_cast<std::size_t>(last - pos) < literal.size() ||
+            literal.compare(0, literal.size(), pos, literal.size())) {
+            return false;
+        }
+
+        reader.first = pos + literal.size();
+        return end_scalar();
+    }
+
+    // Checks that a number or literal ends where the scanner ended its token,
+    // as any character but whitespace or an operator continues it.
+    bool end_scalar()
+    {
+        state = State::Next;
+
+        if (reader.first == last) {
+            return true;
+        }
+
+        switch (char_classes[static_cast<unsigned char>(*reader.first)]) {
+        case CharClass::Whitespace:
+        case CharClass::Operator:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool start_key(const char *pos)
+    {
+        if (*pos != '"') {
+            return false;
+        } else if (checks_keys()) {
+            HashString key;
+            const char *key_end = find_string_special(pos + 1, last);
+
+            // Keys without escapes or non-ASCII characters are hashed as is.
+            if (key_end != last && *key_end == '"') {
+                key.append(pos + 1, key_end - pos - 1);
+            } else {
+                reader.first = pos;
+                reader.read_string(key);
+
+                if (reader.has_error()) {
+                    return false;
+                }
+            }
+
+            if (!keys.insert(key.value, stack.size())) {
+                return false;
+            }
+        }
+
+        state = State::Colon;
+        return true;
+    }
+
+    bool end_container(const char *pos)
+    {
+        if (stack.back() && checks_keys()) {
+            keys.pop_object(stack.size());
+        }
+
+        stack.pop_back();
+
+        if (stack.size()) {
+            state = State::Next;
+        } else {
+            state = State::Done;
+            end = pos + 1;
+        }
+
+        return true;
+    }
+};
+
+// Finds whether the input holds a whole step of `ParseHandler`: whitespace,
+// an optional comma, an optional object key and colon, and then a complete
+// token. Scanning resumes where it stopped when more input arrives, with
+// offsets relative to the start of the step.
+struct StepScanner {
+    enum class State {
+        Start,
+        AfterComma,
+        Key,
+        AfterKey,
+        AfterColon,
+        String,
+        Number,
+        Literal,
+        CommentStart,
+        LineComment,
+        BlockComment,
+        BlockCommentStar,
+    };
+
+    State state = State::Start;
+    State comment_return = State::Start;
+    std::size_t pos = 0;
+    int literal_size = 0;
+    bool escaped = false;
+
+    bool scan(const char *first, const char *last, const ParseOptions &opts)
+    {
+        for (; pos < static_cast<std::size_t>(last - first); ++pos) {
+            if (next(first[pos], opts)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Returns true once the step is complete.
+    bool next(char c, const ParseOptions &opts)
+    {
+        switch (state) {
+        case State::Start:
+        case State::AfterComma:
+        case State::AfterKey:
+        case State::AfterColon:
+            if (is_json_whitespace(c)) {
+                return false;
+            } else if (c == '/' && opts.accept_comments) {
+                comment_return = state;
+                state = State::CommentStart;
+                return false;
+            } else if (c == ',' && state == State::Start) {
+                state = State::AfterComma;
+                return false;
+            } else if (c == '"' && state <= State::AfterComma) {
+                state = State::Key;
+                return false;
+            } else if (c == ':' && state == State::AfterKey) {
+                state = State::AfterColon;
+                return false;
+            } else if (state == State::AfterKey) {
+                return true;
+            }
+
+            return start_token(c);
+        case State::Key:
+        case State::String:
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                if (state == State::String) {
+                    return true;
+                }
+
+                state = State::AfterKey;
+            }
+
+            return false;
+        case State::Number:
+            return !(ascii_isdigit(c) || c == '-' || c == '+' || c == '.' ||
+                     c == 'e' || c == 'E');
+        case State::Literal:
+            return --literal_size == 0;
+        case State::CommentStart:
+            if (c == '/') {
+                state = State::LineComment;
+            } else if (c == '*') {
+                state = State::BlockComment;
+            } else {
+                return true;
+            }
+
+            return false;
+        case State::LineComment:
+            if (c == '\n' || c == '\r') {
+                state = comment_return;
+            }
+
+            return false;
+        case State::BlockComment:
+        case State::BlockCommentStar:
+            if (c == '/' && state == State::BlockCommentStar) {
+                state = comment_return;
+            } else {
+                state = c == '*' ? State::BlockCommentStar
+                                 : State::BlockComment;
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool start_token(char c)
+    {
+        switch (c) {
+        case '"':
+            state = State::String;
+            return false;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            state = State::Number;
+            return false;
+        case 't':
+        case 'n':
+            state = State::Literal;
+            literal_size = 3;
+            return false;
+        case 'f':
+            state = State::Literal;
+            literal_size = 4;
+            return false;
+        default:
+            return true;
+        }
+    }
+};
+
+// Output iterator over a stream buffer, which `OutputBuffer` writes whole
+// blocks to with `sputn`.
+struct StreambufOutput {
+    using difference_type = std::ptrdiff_t;
+
+    std::streambuf *buf;
+    bool failed = false;
+
+    void write(const char *data, std::size_t size)
+    {
+        if (buf->sputn(data, static_cast<std::streamsize>(size)) !=
+            static_cast<std::streamsize>(size)) {
+            failed = true;
+        }
+    }
+
+    StreambufOutput &operator=(char c)
+    {
+        write(&c, 1);
+        return *this;
+    }
+
+    StreambufOutput &operator*() noexcept
+    {
+        return *this;
+    }
+
+    StreambufOutput &operator++() noexcept
+    {
+        return *this;
+    }
+
+    StreambufOutput operator++(int) noexcept
+    {
+        return *this;
+    }
+};
+
+// Output iterator which only counts the characters written to it.
+struct SizeCounter {
+    using difference_type = std::ptrdiff_t;
+
+    std::size_t size = 0;
+
+    void write(const char *, std::size_t n) noexcept
+    {
+        size += n;
+    }
+
+    SizeCounter &operator=(char) noexcept
+    {
+        ++size;
+        return *this;
+    }
+
+    SizeCounter &operator*() noexcept
+    {
+        return *this;
+    }
+
+    SizeCounter &operator++() noexcept
+    {
+        return *this;
+    }
+
+    SizeCounter operator++(int) noexcept
+    {
+        return *this;
+    }
+};
+
+// Output iterator over `[pos, end)`. Once a write does not fit, `overflow` is
+// set and nothing more is written.
+struct BoundedOutput {
+    using difference_type = std::ptrdiff_t;
+
+    char *pos;
+    char *end;
+    bool overflow = false;
+
+    void write(const char *data, std::size_t n) noexcept
+    {
+        if (overflow || n > static_cast<std::size_t>(end - pos)) {
+            overflow = true;
+        } else if (n) {
+            std::memcpy(pos, data, n);
+            pos += n;
+        }
+    }
+
+    BoundedOutput &operator=(char c) noexcept
+    {
+        write(&c, 1);
+        return *this;
+    }
+
+    BoundedOutput &operator*() noexcept
+    {
+        return *this;
+    }
+
+    BoundedOutput &operator++() noexcept
+    {
+        return *this;
+    }
+
+    BoundedOutput operator++(int) noexcept
+    {
+        return *this;
+    }
+};
+
+// Output iterator which fills `[pos, end)` and appends whatever does not fit
+// to `overflow`.
+template <class Alloc>
+struct ChunkOutput {
+    using difference_type = std::ptrdiff_t;
+
+    using Overflow = std::vector<
+        char, typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+
+    char *pos;
+    char *end;
+    Overflow *overflow;
+
+    void write(const char *data, std::size_t n)
+    {
+        std::size_t size = std::min(n, static_cast<std::size_t>(end - pos));
+
+        if (size) {
+            std::memcpy(pos, data, size);
+            pos += size;
+        }
+
+        overflow->insert(overflow->end(), data + size, data + n);
+    }
+
+    ChunkOutput &operator=(char c)
+    {
+        write(&c, 1);
+        return *this;
+    }
+
+    ChunkOutput &operator*() noexcept
+    {
+        return *this;
+    }
+
+    ChunkOutput &operator++() noexcept
+    {
+        return *this;
+    }
+
+    ChunkOutput operator++(int) noexcept
+    {
+        return *this;
+    }
+};
+
+template <class O>
+class OutputBuffer;
+
+// Output iterator which writes through an `OutputBuffer`.
+template <class O>
+struct OutputBufferInserter {
+    using difference_type = std::ptrdiff_t;
+
+    OutputBuffer<O> *buffer;
+
+    OutputBufferInserter &operator=(char c)
+    {
+        buffer->put(c);
+        return *this;
+    }
+
+    OutputBufferInserter &operator*() noexcept
+    {
+        return *this;
+    }
+
+    OutputBufferInserter &operator++() noexcept
+    {
+        return *this;
+    }
+
+    OutputBufferInserter operator++(int) noexcept
+    {
+        return *this;
+    }
+};
+
+template <class O>
+concept contiguous_char_output =
+    std::contiguous_iterator<O> && std::same_as<std::iter_value_t<O>, char>;
+
+template <class T>
+inline constexpr bool is_output_buffer_inserter = false;
+
+template <class O>
+inline constexpr bool is_output_buffer_inserter<OutputBufferInserter<O>> =
+    true;
+
+template <class T>
+inline constexpr bool is_direct_output =
+    std::same_as<T, SizeCounter> || std::same_as<T, BoundedOutput>;
+
+template <class Alloc>
+inline constexpr bool is_direct_output<ChunkOutput<Alloc>> = true;
+
+// Whether `T` is a `std::back_insert_iterator` to a container which can
+// insert a range of characters at once.
+template <class T>
+inline constexpr bool is_range_back_inserter = false;
+
+template <class C>
+    requires requires(C &c, const char *p) { c.insert(c.end(), p, p); }
+inline constexpr bool is_range_back_inserter<std::back_insert_iterator<C>> =
+    true;
+
+// The container a `std::back_insert_iterator` appends to, which the standard
+// keeps in a protected member.
+template <class C>
+inline C &back_insert_container(std::back_insert_iterator<C> &it) noexcept
+{
+    struct Access : std::back_insert_iterator<C> {
+        static C *get(std::back_insert_iterator<C> &it) noexcept
+        {
+            return it.*&Access::container;
+        }
+    };
+
+    return *Access::get(it);
+}
+
+// Collects the output of `SerializeHandler` into blocks, so that `dest`
+// receives whole blocks rather than single characters. Contiguous
+// destinations are written directly, containers behind
+// `std::back_insert_iterator` are appended to with `insert` where they have
+// it, and stream buffers with `sputn`.
+template <class O>
+class OutputBuffer {
+public:
+    static constexpr std::size_t block_size = 4096;
+
+    static constexpr bool is_contiguous = contiguous_char_output<O>;
+
+    static constexpr bool is_direct =
+        is_contiguous || is_output_buffer_inserter<O> || is_direct_output<O>;
+
+    O dest;
+
+    explicit OutputBuffer(O dest) : dest(std::move(dest)), _size(0) {}
+
+    OutputBuffer(const OutputBuffer &) = delete;
+
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    OutputBufferInserter<O> inserter() noexcept
+    {
+        return { this };
+    }
+
+    void put(char c)
+    {
+        if constexpr (is_direct) {
+            *dest = c;
+            ++dest;
+        } else {
+            if (_size == block_size) {
+                flush();
+            }
+
+            _block[_size++] = c;
+        }
+    }
+
+    void append(const char *data, std::size_t size)
+    {
+        if constexpr (is_contiguous) {
+            std::memcpy(std::to_address(dest), data, size);
+            dest += size;
+        } else if constexpr (is_output_buffer_inserter<O>) {
+            dest.buffer->append(data, size);
+        } else if constexpr (is_direct_output<O>) {
+            dest.write(data, size);
+        } else if (size <= block_size - _size) {
+            std::memcpy(_block.data() + _size, data, size);
+            _size += size;
+        } else {
+            flush();
+            if (size < block_size) {
+                std::memcpy(_block.data(), data, size);
+                _size = size;
+            } else {
+                write_block(data, size);
+            }
+        }
+    }
+
+    void flush()
+    {
+        if constexpr (!is_direct) {
+            write_block(_block.data(), _size);
+            _size = 0;
+        }
+    }
+
+    // Flushes the buffer and returns the destination past the output.
+    O release()
+    {
+        flush();
+        return std::move(dest);
+    }
+
+private:
+    using Block =
+        std::conditional_t<is_direct, std::monostate,
+                           std::array<char, block_size>>;
+
+    [[no_unique_address]] Block _block;
+    std::size_t _size;
+
+    void write_block(const char *data, std::size_t size)
+    {
+        if constexpr (is_range_back_inserter<O>) {
+            auto &container = back_insert_container(dest);
+
+            container.insert(container.end(), data, data + size);
+        } else if constexpr (std::same_as<O, StreambufOutput>) {
+            dest.write(data, size);
+        } else {
+            dest = std::ranges::copy(data, data + size, std::move(dest)).out;
+        }
+    }
+};
+
+template <class Alloc>
+struct SerializePosition {
+    using DocumentType = BasicDocument<Alloc>;
+    using ArrayType = BasicArray<Alloc>;
+    using ObjectType = BasicObject<Alloc>;
+    using ArrayIt = ArrayType::const_iterator;
+    using ObjectIt = ObjectType::const_iterator;
 
     SerializePosition(const DocumentType &value, ArrayIt it)
         : value(std::addressof(value)), array_it(it)
@@ -1026,26 +3437,26 @@ struct SerializeHandler {
 
     using Stack = std::vector<SerializePosition<Alloc>, StackAlloc>;
 
-    O out;
+    // Output is buffered until `out.release()`, which returns the
+    // destination.
+    OutputBuffer<O> out;
     Stack stack;
     SerializeOptions opts;
     std::size_t indent_depth;
 
     SerializeHandler(O out, const Alloc &alloc, const SerializeOptions &opts)
-        : out(out), stack(StackAlloc(alloc)), opts(opts), indent_depth(0)
+        : out(std::move(out)), stack(StackAlloc(alloc)), opts(opts),
+          indent_depth(0)
     {}
 
     void write(char c)
     {
-        *out = c;
-        ++out;
+        out.put(c);
     }
 
     void write(const char *str)
     {
-        for (; *str; ++str) {
-            write(*str);
-        }
+        write(std::string_view(str));
     }
 
     template <std::input_iterator I, std::sentinel_for<I> S>
@@ -1059,9 +3470,7 @@ struct SerializeHandler {
 
     void write(std::string_view value)
     {
-        for (char c: value) {
-            write(c);
-        }
+        out.append(value.data(), value.size());
     }
 
     void serialize(Null)
@@ -1079,7 +3488,7 @@ struct SerializeHandler {
         char buf[std::numeric_limits<decltype(value)>::digits10 + 3];
         auto res = std::to_chars(buf, std::end(buf), value);
 
-        write(buf, res.ptr);
+        write(std::string_view(buf, res.ptr));
     }
 
     void serialize(std::floating_point auto value)
@@ -1088,17 +3497,30 @@ struct SerializeHandler {
         char buf[std::numeric_limits<decltype(value)>::max_digits10 + 10];
         auto res = std::to_chars(buf, std::end(buf), value);
 
-        write(buf, res.ptr);
+        write(std::string_view(buf, res.ptr));
     }
 
     void serialize(const BasicString<Alloc> &value)
+    {
+        serialize_string(value);
+    }
+
+    void serialize_string(std::string_view value)
     {
         write('"');
 
         auto first = value.data();
         auto last = first + value.size();
 
-        for (; first != last;) {
+        for (;;) {
+            auto run = find_verbatim_run(first, last);
+
+            write(std::string_view(first, run));
+
+            if ((first = run) == last) {
+                break;
+            }
+
             char32_t code_point;
 
             if (!read_utf8_char(first, last, code_point)) {
@@ -1106,7 +3528,7 @@ struct SerializeHandler {
             }
 
             if (!write_escaped_character(code_point)) {
-                write_utf8_char(out, code_point);
+                write_utf8_char(out.inserter(), code_point);
             }
         }
 
@@ -1129,21 +3551,6 @@ struct SerializeHandler {
         case '\\':
             write("\\\\");
             break;
-        case '\b':
-            write("\\\b");
-            break;
-        case '\f':
-            write("\\\f");
-            break;
-        case '\n':
-            write("\\\n");
-            break;
-        case '\r':
-            write("\\\r");
-            break;
-        case '\t':
-            write("\\\t");
-            break;
         default:
             return false;
         }
@@ -1158,17 +3565,18 @@ struct SerializeHandler {
         if (value.size()) {
             indent();
 
-            auto first = value.begin();
-            auto last = value.end();
-
-            serialize(*first);
+            for (auto first = value.begin(); first != value.end(); ++first) {
+                if (first != value.begin()) {
+                    write(',');
+                    newline();
+                }
 
-            for (; first != last; ++first) {
-                write(',');
+                write_indent();
                 serialize(*first);
             }
 
             dedent();
+            write_indent();
         }
 
         write(']');
@@ -1181,16 +3589,12 @@ struct SerializeHandler {
         if (value.size()) {
             indent();
 
-            auto first = value.begin();
-            auto last = value.end();
-
-            write_indent();
-            serialize(first->first);
-            write(':');
-            serialize(first->second);
+            for (auto first = value.begin(); first != value.end(); ++first) {
+                if (first != value.begin()) {
+                    write(',');
+                    newline();
+                }
 
-            for (; first != last; ++first) {
-                write(',');
                 write_indent();
                 serialize(first->first);
                 write(':');
@@ -1198,6 +3602,7 @@ struct SerializeHandler {
             }
 
             dedent();
+            write_indent();
         }
 
         write('}');
@@ -1225,6 +3630,7 @@ struct SerializeHandler {
     {
         if (pos.is_array_last()) {
             dedent();
+            write_indent();
             write(']');
             stack.pop_back();
             return;
@@ -1241,6 +3647,7 @@ struct SerializeHandler {
     {
         if (pos.is_object_last()) {
             dedent();
+            write_indent();
             write('}');
             stack.pop_back();
             return;
@@ -1255,7 +3662,6 @@ struct SerializeHandler {
 
     void start_entry(auto &entry)
     {
-        write_indent();
         serialize(entry.first);
         write(':');
         start_document(entry.second);
@@ -1271,13 +3677,17 @@ struct SerializeHandler {
             serialize(value.get_bool());
             break;
         case Type::Int:
-            serialize(value.get_int());
-            break;
         case Type::Float:
-            serialize(value.get_float());
+            if (auto text = value.get_number_text(); text.size()) {
+                write(text);
+            } else if (value.is_int()) {
+                serialize(value.get_int());
+            } else {
+                serialize(value.get_float());
+            }
             break;
         case Type::String:
-            serialize(value.get_string());
+            serialize_string(value.get_string_view());
             break;
         case Type::Array:
             if (value.get_array().size()) {
@@ -1325,6 +3735,42 @@ struct SerializeHandler {
             write('\n');
         }
     }
+
+    // Writes the opening bracket or the comma before an element, and the
+    // indentation after it.
+    void next_element(char c, bool first)
+    {
+        write(c);
+
+        if (first) {
+            indent();
+        } else {
+            newline();
+        }
+
+        write_indent();
+    }
+
+    void end_container(char close)
+    {
+        dedent();
+        write_indent();
+        write(close);
+    }
+
+    // Serializes a document, string, array or object of any allocator at the
+    // current indentation.
+    template <class T>
+    void serialize_nested(const T &value)
+    {
+        using ValueAlloc = typename T::allocator_type;
+
+        SerializeHandler<OutputBufferInserter<O>, ValueAlloc> handler(
+            out.inserter(), value.get_allocator(), opts);
+
+        handler.indent_depth = indent_depth;
+        handler.serialize(value);
+    }
 };
 
 } // namespace htl::json::detail
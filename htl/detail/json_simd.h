@@ -0,0 +1,898 @@
+#ifndef HTL_DETAIL_JSON_SIMD_H_
+#define HTL_DETAIL_JSON_SIMD_H_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <htl/config.h>
+
+// Define `HTL_JSON_NO_SIMD` to force the portable implementations.
+#if !defined(HTL_JSON_NO_SIMD)
+#if defined(__AVX2__)
+#define HTL_JSON_AVX2 1
+#define HTL_JSON_SSSE3 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HTL_JSON_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#define HTL_JSON_SSSE3 1
+#include <tmmintrin.h>
+#endif
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#define HTL_JSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__PCLMUL__)
+#define HTL_JSON_PCLMUL 1
+#include <wmmintrin.h>
+#endif
+#endif
+
+namespace htl::json::detail {
+
+inline constexpr std::size_t simd_block_size = 64;
+
+enum class CharClass : unsigned char {
+    Other,
+    Whitespace,
+    Operator,
+    Quote,
+    Backslash,
+};
+
+inline constexpr auto char_classes = [] {
+    std::array<CharClass, 256> table{};
+
+    table[' '] = CharClass::Whitespace;
+    table['\t'] = CharClass::Whitespace;
+    table['\n'] = CharClass::Whitespace;
+    table['\r'] = CharClass::Whitespace;
+    table['{'] = CharClass::Operator;
+    table['}'] = CharClass::Operator;
+    table['['] = CharClass::Operator;
+    table[']'] = CharClass::Operator;
+    table[':'] = CharClass::Operator;
+    table[','] = CharClass::Operator;
+    table['"'] = CharClass::Quote;
+    table['\\'] = CharClass::Backslash;
+
+    return table;
+}();
+
+inline bool is_json_whitespace(char c) noexcept
+{
+    return char_classes[static_cast<unsigned char>(c)] == CharClass::Whitespace;
+}
+
+// Character masks for a 64 byte block, bit `i` set for byte `i`.
+struct BlockMasks {
+    std::uint64_t backslash;
+    std::uint64_t quote;
+    std::uint64_t op;
+    std::uint64_t whitespace;
+    std::uint64_t control;
+};
+
+#if HTL_JSON_AVX2
+inline std::uint64_t avx2_mask(__m256i lo, __m256i hi) noexcept
+{
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(lo)) |
+           (static_cast<std::uint64_t>(
+                static_cast<std::uint32_t>(_mm256_movemask_epi8(hi)))
+            << 32);
+}
+
+inline BlockMasks classify_block(const char *p) noexcept
+{
+    __m256i v[2];
+    __m256i case_bit = _mm256_set1_epi8(0x20);
+    __m256i max_control = _mm256_set1_epi8(0x1F);
+    __m256i backslash[2];
+    __m256i quote[2];
+    __m256i op[2];
+    __m256i whitespace[2];
+    __m256i control[2];
+
+    auto eq = [](__m256i v, char c) {
+        return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+    };
+
+    for (int i = 0; i < 2; ++i) {
+        v[i] = _mm256_loadu_si256(static_cast<const __m256i *>(
+            static_cast<const void *>(p + 32 * i)));
+
+        // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for the
+        // closers.
+        __m256i folded = _mm256_or_si256(v[i], case_bit);
+
+        backslash[i] = eq(v[i], '\\');
+        quote[i] = eq(v[i], '"');
+        op[i] = _mm256_or_si256(
+            _mm256_or_si256(eq(folded, '{'), eq(folded, '}')),
+            _mm256_or_si256(eq(v[i], ':'), eq(v[i], ',')));
+        whitespace[i] = _mm256_or_si256(
+            _mm256_or_si256(eq(v[i], ' '), eq(v[i], '\t')),
+            _mm256_or_si256(eq(v[i], '\n'), eq(v[i], '\r')));
+
+        // Unsigned bytes below 0x20 are unchanged by the minimum with 0x1F.
+        control[i] =
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v[i], max_control), v[i]);
+    }
+
+    return {
+        avx2_mask(backslash[0], backslash[1]),
+        avx2_mask(quote[0], quote[1]),
+        avx2_mask(op[0], op[1]),
+        avx2_mask(whitespace[0], whitespace[1]),
+        avx2_mask(control[0], control[1]),
+    };
+}
+#elif HTL_JSON_SSE2
+inline BlockMasks classify_block(const char *p) noexcept
+{
+    __m128i case_bit = _mm_set1_epi8(0x20);
+    __m128i max_control = _mm_set1_epi8(0x1F);
+    BlockMasks masks{};
+
+    auto eq = [](__m128i v, char c) {
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+    };
+
+    auto bits = [](__m128i v, int i) {
+        return static_cast<std::uint64_t>(
+                   static_cast<std::uint16_t>(_mm_movemask_epi8(v)))
+               << (16 * i);
+    };
+
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128(static_cast<const __m128i *>(
+            static_cast<const void *>(p + 16 * i)));
+
+        // '{' | 0x20 == '{', '[' | 0x20 == '{', and likewise for the
+        // closers.
+        __m128i folded = _mm_or_si128(v, case_bit);
+        __m128i op =
+            _mm_or_si128(_mm_or_si128(eq(folded, '{'), eq(folded, '}')),
+                         _mm_or_si128(eq(v, ':'), eq(v, ',')));
+        __m128i whitespace =
+            _mm_or_si128(_mm_or_si128(eq(v, ' '), eq(v, '\t')),
+                         _mm_or_si128(eq(v, '\n'), eq(v, '\r')));
+
+        // Unsigned bytes below 0x20 are unchanged by the minimum with 0x1F.
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, max_control), v);
+
+        masks.backslash |= bits(eq(v, '\\'), i);
+        masks.quote |= bits(eq(v, '"'), i);
+        masks.op |= bits(op, i);
+        masks.whitespace |= bits(whitespace, i);
+        masks.control |= bits(control, i);
+    }
+
+    return masks;
+}
+#elif HTL_JSON_NEON
+// Bit `i` of the result is set if byte `i` of `src[i / 16]` is.
+inline std::uint64_t neon_movemask(const uint8x16_t *src)
+{
+    static constexpr std::uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                               1, 2, 4, 8, 16, 32, 64, 128 };
+
+    uint8x16_t bit_values = vld1q_u8(bits);
+    std::uint64_t result = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        uint8x16_t m = vandq_u8(src[i], bit_values);
+        std::uint64_t lo = vaddv_u8(vget_low_u8(m));
+        std::uint64_t hi = vaddv_u8(vget_high_u8(m));
+        result |= (lo | (hi << 8)) << (16 * i);
+    }
+
+    return result;
+}
+
+inline std::uint64_t neon_mask(const uint8x16_t *src, uint8x16_t pattern)
+{
+    uint8x16_t eq[4];
+
+    for (int i = 0; i < 4; ++i) {
+        eq[i] = vceqq_u8(src[i], pattern);
+    }
+
+    return neon_movemask(eq);
+}
+
+inline BlockMasks classify_block(const char *p) noexcept
+{
+    uint8x16_t v[4];
+    uint8x16_t folded[4];
+    uint8x16_t case_bit = vdupq_n_u8(0x20);
+
+    for (int i = 0; i < 4; ++i) {
+        v[i] = vld1q_u8(reinterpret_cast<const std::uint8_t *>(p + 16 * i));
+        folded[i] = vorrq_u8(v[i], case_bit);
+    }
+
+    auto mask = [](const uint8x16_t *src, char c) {
+        return neon_mask(src, vdupq_n_u8(static_cast<std::uint8_t>(c)));
+    };
+
+    uint8x16_t control[4];
+
+    for (int i = 0; i < 4; ++i) {
+        control[i] = vcltq_u8(v[i], vdupq_n_u8(0x20));
+    }
+
+    return {
+        mask(v, '\\'),
+        mask(v, '"'),
+        mask(folded, '{') | mask(folded, '}') | mask(v, ':') | mask(v, ','),
+        mask(v, ' ') | mask(v, '\t') | mask(v, '\n') | mask(v, '\r'),
+        neon_movemask(control),
+    };
+}
+#else
+inline BlockMasks classify_block(const char *p) noexcept
+{
+    BlockMasks masks{};
+
+    for (std::size_t i = 0; i < simd_block_size; ++i) {
+        std::uint64_t bit = std::uint64_t(1) << i;
+
+        if (static_cast<unsigned char>(p[i]) < 0x20) {
+            masks.control |= bit;
+        }
+
+        switch (char_classes[static_cast<unsigned char>(p[i])]) {
+        case CharClass::Whitespace:
+            masks.whitespace |= bit;
+            break;
+        case CharClass::Operator:
+            masks.op |= bit;
+            break;
+        case CharClass::Quote:
+            masks.quote |= bit;
+            break;
+        case CharClass::Backslash:
+            masks.backslash |= bit;
+            break;
+        }
+    }
+
+    return masks;
+}
+#endif
+
+// Whether `c` ends a run of string characters that can be copied as is: a
+// quote, a backslash, a control character, or any non-ASCII byte.
+inline bool is_string_special(char c) noexcept
+{
+    auto b = static_cast<unsigned char>(c);
+    return b == '"' || b == '\\' || b < 0x20 || b >= 0x80;
+}
+
+// Finds the first byte of `[first, last)` for which `is_string_special` is
+// true, or `last`.
+inline const char *find_string_special(const char *first, const char *last)
+{
+#if HTL_JSON_AVX2
+    __m256i quote = _mm256_set1_epi8('"');
+    __m256i backslash = _mm256_set1_epi8('\\');
+    __m256i space = _mm256_set1_epi8(0x20);
+
+    for (; last - first >= 32; first += 32) {
+        __m256i v = _mm256_loadu_si256(
+            static_cast<const __m256i *>(static_cast<const void *>(first)));
+
+        // Signed comparison, so bytes >= 0x80 are below 0x20 as well.
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                            _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpgt_epi8(space, v));
+
+        if (auto mask = static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(special))) {
+            return first + std::countr_zero(mask);
+        }
+    }
+#elif HTL_JSON_SSE2
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i backslash = _mm_set1_epi8('\\');
+    __m128i space = _mm_set1_epi8(0x20);
+
+    for (; last - first >= 16; first += 16) {
+        __m128i v = _mm_loadu_si128(
+            static_cast<const __m128i *>(static_cast<const void *>(first)));
+
+        // Signed comparison, so bytes >= 0x80 are below 0x20 as well.
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                         _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmplt_epi8(v, space));
+
+        if (auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(special))) {
+            return first + std::countr_zero(mask);
+        }
+    }
+#elif HTL_JSON_NEON
+    uint8x16_t quote = vdupq_n_u8('"');
+    uint8x16_t backslash = vdupq_n_u8('\\');
+    int8x16_t space = vdupq_n_s8(0x20);
+
+    for (; last - first >= 16; first += 16) {
+        uint8x16_t v =
+            vld1q_u8(reinterpret_cast<const std::uint8_t *>(first));
+
+        // Signed comparison, so bytes >= 0x80 are below 0x20 as well.
+        uint8x16_t special =
+            vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                     vcltq_s8(vreinterpretq_s8_u8(v), space));
+
+        // Four bits per byte.
+        std::uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(
+                vshrn_n_u16(vreinterpretq_u16_u8(special), 4)),
+            0);
+
+        if (mask) {
+            return first + std::countr_zero(mask) / 4;
+        }
+    }
+#endif
+
+    while (first != last && !is_string_special(*first)) {
+        ++first;
+    }
+
+    return first;
+}
+
+// Bit `i` of the result is the parity of bits `0..i` of `x`.
+inline std::uint64_t prefix_xor(std::uint64_t x) noexcept
+{
+#if HTL_JSON_PCLMUL
+    __m128i value = _mm_set_epi64x(0, static_cast<long long>(x));
+    __m128i ones = _mm_set1_epi8(-1);
+    return static_cast<std::uint64_t>(
+        _mm_cvtsi128_si64(_mm_clmulepi64_si128(value, ones, 0)));
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+// Finds the structural characters of consecutive 64 byte blocks: the
+// operators outside of strings, the opening quote of each string, and the
+// first byte of every other scalar.
+//
+// Based on the first stage of simdjson, see "Parsing Gigabytes of JSON per
+// Second" (Langdale, Lemire; https://arxiv.org/abs/1902.08318).
+class StructuralScanner {
+public:
+    std::uint64_t next(const BlockMasks &masks) noexcept
+    {
+        std::uint64_t escaped = find_escaped(masks.backslash);
+        std::uint64_t quote = masks.quote & ~escaped;
+        std::uint64_t in_string = prefix_xor(quote) ^ _prev_in_string;
+
+        _prev_in_string = static_cast<std::uint64_t>(
+            static_cast<std::int64_t>(in_string) >> 63);
+
+        std::uint64_t scalar = ~(masks.op | masks.whitespace);
+        std::uint64_t nonquote_scalar = scalar & ~quote;
+        std::uint64_t follows_scalar = (nonquote_scalar << 1) | _prev_scalar;
+
+        _prev_scalar = nonquote_scalar >> 63;
+
+        std::uint64_t scalar_start = scalar & ~follows_scalar;
+
+        _escaped = escaped;
+        _string_tail = in_string ^ quote;
+
+        return (masks.op | scalar_start) & ~_string_tail;
+    }
+
+    // Whether the next block starts within a string, and not just after a
+    // backslash. A block with no quotes, backslashes or control characters
+    // then need not be scanned, as it is only string characters.
+    bool in_string() const noexcept
+    {
+        return _prev_in_string && !_prev_escaped;
+    }
+
+    // The characters of the last block preceded by an odd length run of
+    // backslashes.
+    std::uint64_t escaped() const noexcept
+    {
+        return _escaped;
+    }
+
+    // The characters of the last block within strings, after their opening
+    // quotes and up to and including their closing quotes.
+    std::uint64_t string_tail() const noexcept
+    {
+        return _string_tail;
+    }
+
+private:
+    std::uint64_t _prev_escaped = 0;
+    std::uint64_t _prev_in_string = 0;
+    std::uint64_t _prev_scalar = 0;
+    std::uint64_t _escaped = 0;
+    std::uint64_t _string_tail = 0;
+
+    // Marks the characters preceded by an odd length run of backslashes.
+    std::uint64_t find_escaped(std::uint64_t backslash) noexcept
+    {
+        constexpr std::uint64_t even_bits = 0x5555555555555555;
+
+        backslash &= ~_prev_escaped;
+
+        std::uint64_t follows_escape = (backslash << 1) | _prev_escaped;
+        std::uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+        std::uint64_t even_sequences = odd_starts + backslash;
+
+        _prev_escaped = even_sequences < odd_starts;
+
+        std::uint64_t invert_mask = even_sequences << 1;
+        return (even_bits ^ invert_mask) & follows_escape;
+    }
+};
+
+#if HTL_JSON_SSSE3
+using Vector128 = __m128i;
+
+inline Vector128 vector_load(const void *p) noexcept
+{
+    return _mm_loadu_si128(static_cast<const __m128i *>(p));
+}
+
+inline Vector128 vector_splat(std::uint8_t c) noexcept
+{
+    return _mm_set1_epi8(static_cast<char>(c));
+}
+
+inline Vector128 vector_and(Vector128 a, Vector128 b) noexcept
+{
+    return _mm_and_si128(a, b);
+}
+
+inline Vector128 vector_or(Vector128 a, Vector128 b) noexcept
+{
+    return _mm_or_si128(a, b);
+}
+
+inline Vector128 vector_xor(Vector128 a, Vector128 b) noexcept
+{
+    return _mm_xor_si128(a, b);
+}
+
+inline Vector128 vector_eq(Vector128 a, Vector128 b) noexcept
+{
+    return _mm_cmpeq_epi8(a, b);
+}
+
+inline Vector128 vector_saturating_sub(Vector128 a, Vector128 b) noexcept
+{
+    return _mm_subs_epu8(a, b);
+}
+
+inline Vector128 vector_high_nibbles(Vector128 v) noexcept
+{
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+inline Vector128 vector_low_nibbles(Vector128 v) noexcept
+{
+    return _mm_and_si128(v, _mm_set1_epi8(0x0F));
+}
+
+inline Vector128 vector_lookup(Vector128 table, Vector128 index) noexcept
+{
+    return _mm_shuffle_epi8(table, index);
+}
+
+// The last `N` bytes of `prev` followed by the first `16 - N` of `v`.
+template <int N>
+inline Vector128 vector_prev(Vector128 v, Vector128 prev) noexcept
+{
+    return _mm_alignr_epi8(v, prev, 16 - N);
+}
+
+inline bool vector_any(Vector128 v) noexcept
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;
+}
+
+inline bool vector_is_ascii(Vector128 v) noexcept
+{
+    return _mm_movemask_epi8(v) == 0;
+}
+#elif HTL_JSON_NEON
+using Vector128 = uint8x16_t;
+
+inline Vector128 vector_load(const void *p) noexcept
+{
+    return vld1q_u8(static_cast<const std::uint8_t *>(p));
+}
+
+inline Vector128 vector_splat(std::uint8_t c) noexcept
+{
+    return vdupq_n_u8(c);
+}
+
+inline Vector128 vector_and(Vector128 a, Vector128 b) noexcept
+{
+    return vandq_u8(a, b);
+}
+
+inline Vector128 vector_or(Vector128 a, Vector128 b) noexcept
+{
+    return vorrq_u8(a, b);
+}
+
+inline Vector128 vector_xor(Vector128 a, Vector128 b) noexcept
+{
+    return veorq_u8(a, b);
+}
+
+inline Vector128 vector_eq(Vector128 a, Vector128 b) noexcept
+{
+    return vceqq_u8(a, b);
+}
+
+inline Vector128 vector_saturating_sub(Vector128 a, Vector128 b) noexcept
+{
+    return vqsubq_u8(a, b);
+}
+
+inline Vector128 vector_high_nibbles(Vector128 v) noexcept
+{
+    return vshrq_n_u8(v, 4);
+}
+
+inline Vector128 vector_low_nibbles(Vector128 v) noexcept
+{
+    return vandq_u8(v, vdupq_n_u8(0x0F));
+}
+
+inline Vector128 vector_lookup(Vector128 table, Vector128 index) noexcept
+{
+    return vqtbl1q_u8(table, index);
+}
+
+// The last `N` bytes of `prev` followed by the first `16 - N` of `v`.
+template <int N>
+inline Vector128 vector_prev(Vector128 v, Vector128 prev) noexcept
+{
+    return vextq_u8(prev, v, 16 - N);
+}
+
+inline bool vector_any(Vector128 v) noexcept
+{
+    return vmaxvq_u8(v) != 0;
+}
+
+inline bool vector_is_ascii(Vector128 v) noexcept
+{
+    return vmaxvq_u8(v) < 0x80;
+}
+#endif
+
+// Checks that consecutive 64 byte blocks are well formed UTF-8: no overlong
+// forms, surrogates, code points past U+10FFFF or truncated sequences. Byte
+// pairs which may begin a noncharacter are rejected as well, as strings may
+// not hold those by default, along with a few valid characters.
+//
+// The SIMD version uses the lookup tables of "Validating UTF-8 In Less Than
+// One Instruction Per Byte" (Keiser, Lemire; https://arxiv.org/abs/2010.03090).
+#if HTL_JSON_SSSE3 || HTL_JSON_NEON
+class Utf8Checker {
+public:
+    Utf8Checker() noexcept
+        : _error(vector_splat(0)), _prev(vector_splat(0)),
+          _prev_incomplete(vector_splat(0))
+    {}
+
+    void next(const char *p) noexcept
+    {
+        Vector128 v[4];
+
+        for (int i = 0; i < 4; ++i) {
+            v[i] = vector_load(p + 16 * i);
+        }
+
+        if (vector_is_ascii(vector_or(vector_or(v[0], v[1]),
+                                      vector_or(v[2], v[3])))) {
+            _error = vector_or(_error, _prev_incomplete);
+            _prev = v[3];
+            _prev_incomplete = vector_splat(0);
+            return;
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            check(v[i]);
+        }
+    }
+
+    // Whether the blocks so far are valid and end on a whole character.
+    bool valid() const noexcept
+    {
+        return !vector_any(vector_or(_error, _prev_incomplete));
+    }
+
+private:
+    static constexpr std::uint8_t too_short = 1 << 0;
+    static constexpr std::uint8_t too_long = 1 << 1;
+    static constexpr std::uint8_t overlong_3 = 1 << 2;
+    static constexpr std::uint8_t too_large = 1 << 3;
+    static constexpr std::uint8_t surrogate = 1 << 4;
+    static constexpr std::uint8_t overlong_2 = 1 << 5;
+    static constexpr std::uint8_t too_large_1000 = 1 << 6;
+    static constexpr std::uint8_t overlong_4 = 1 << 6;
+    static constexpr std::uint8_t two_conts = 1 << 7;
+    static constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+    // Indexed by the high nibble of the first byte of a pair.
+    static constexpr std::uint8_t byte_1_high[16] = {
+        too_long, too_long, too_long, too_long,
+        too_long, too_long, too_long, too_long,
+        two_conts, two_conts, two_conts, two_conts,
+        too_short | overlong_2,
+        too_short,
+        too_short | overlong_3 | surrogate,
+        too_short | too_large | too_large_1000 | overlong_4,
+    };
+
+    // Indexed by the low nibble of the first byte of a pair.
+    static constexpr std::uint8_t byte_1_low[16] = {
+        carry | overlong_3 | overlong_2 | overlong_4,
+        carry | overlong_2,
+        carry,
+        carry,
+        carry | too_large,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000 | surrogate,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+    };
+
+    // Indexed by the high nibble of the second byte of a pair.
+    static constexpr std::uint8_t byte_2_high[16] = {
+        too_short, too_short, too_short, too_short,
+        too_short, too_short, too_short, too_short,
+        too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 |
+            overlong_4,
+        too_long | overlong_2 | two_conts | overlong_3 | too_large,
+        too_long | overlong_2 | two_conts | surrogate | too_large,
+        too_long | overlong_2 | two_conts | surrogate | too_large,
+        too_short, too_short, too_short, too_short,
+    };
+
+    // Bytes greater than these in the last three positions begin a
+    // sequence which continues into the next block.
+    static constexpr std::uint8_t max_complete[16] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF,
+    };
+
+    Vector128 _error;
+    Vector128 _prev;
+    Vector128 _prev_incomplete;
+
+    void check(Vector128 v) noexcept
+    {
+        Vector128 prev1 = vector_prev<1>(v, _prev);
+        Vector128 special = vector_and(
+            vector_and(
+                vector_lookup(vector_load(byte_1_high),
+                              vector_high_nibbles(prev1)),
+                vector_lookup(vector_load(byte_1_low),
+                              vector_low_nibbles(prev1))),
+            vector_lookup(vector_load(byte_2_high), vector_high_nibbles(v)));
+
+        // Only third and fourth bytes may follow another continuation.
+        Vector128 must_continue = vector_or(
+            vector_saturating_sub(vector_prev<2>(v, _prev),
+                                  vector_splat(0xE0 - 0x80)),
+            vector_saturating_sub(vector_prev<3>(v, _prev),
+                                  vector_splat(0xF0 - 0x80)));
+        Vector128 length_error = vector_xor(
+            vector_and(must_continue, vector_splat(0x80)), special);
+
+        // EF B7 begins U+FDD0 to U+FDEF, and BF BE or BF BF ends U+xFFFE and
+        // U+xFFFF.
+        Vector128 noncharacter = vector_or(
+            vector_and(vector_eq(prev1, vector_splat(0xEF)),
+                       vector_eq(v, vector_splat(0xB7))),
+            vector_and(vector_eq(prev1, vector_splat(0xBF)),
+                       vector_saturating_sub(v, vector_splat(0xBD))));
+
+        _error = vector_or(_error, vector_or(length_error, noncharacter));
+        _prev_incomplete =
+            vector_saturating_sub(v, vector_load(max_complete));
+        _prev = v;
+    }
+};
+#else
+class Utf8Checker {
+public:
+    void next(const char *p) noexcept
+    {
+        std::uint64_t words[simd_block_size / 8];
+        std::uint64_t any = 0;
+
+        std::memcpy(words, p, simd_block_size);
+        for (auto word: words) {
+            any |= word;
+        }
+
+        if (!_remaining && !(any & 0x8080808080808080)) {
+            _prev = 0;
+            return;
+        }
+
+        for (std::size_t i = 0; i < simd_block_size; ++i) {
+            check(static_cast<unsigned char>(p[i]));
+        }
+    }
+
+    bool valid() const noexcept
+    {
+        return !_error && !_remaining;
+    }
+
+private:
+    bool _error = false;
+    int _remaining = 0;
+    unsigned char _min = 0x80;
+    unsigned char _max = 0xBF;
+    unsigned char _prev = 0;
+
+    // See Table 3-7 of the Unicode Standard:
+    // https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf#page=55
+    void check(unsigned char b) noexcept
+    {
+        if ((_prev == 0xEF && b == 0xB7) || (_prev == 0xBF && b >= 0xBE)) {
+            _error = true;
+        }
+
+        _prev = b;
+
+        if (_remaining) {
+            _error |= b < _min || b > _max;
+            _min = 0x80;
+            _max = 0xBF;
+            --_remaining;
+        } else if (b < 0x80) {
+        } else if (b >= 0xC2 && b <= 0xDF) {
+            _remaining = 1;
+        } else if (b >= 0xE0 && b <= 0xEF) {
+            _remaining = 2;
+            _min = b == 0xE0 ? 0xA0 : 0x80;
+            _max = b == 0xED ? 0x9F : 0xBF;
+        } else if (b >= 0xF0 && b <= 0xF4) {
+            _remaining = 3;
+            _min = b == 0xF0 ? 0x90 : 0x80;
+            _max = b == 0xF4 ? 0x8F : 0xBF;
+        } else {
+            _error = true;
+        }
+    }
+};
+#endif
+
+template <class Index>
+inline void append_structurals(
+    Index &dest, std::size_t offset, std::uint64_t bits)
+{
+    auto size = dest.size();
+    dest.resize(size + std::popcount(bits));
+
+    for (auto out = dest.data() + size; bits; bits &= bits - 1) {
+        *out++ = static_cast<typename Index::value_type>(
+            offset + std::countr_zero(bits));
+    }
+}
+
+// Appends the offsets of the structural characters of `[first, last)` to
+// `dest`.
+template <class Index>
+inline void build_structural_index(
+    const char *first, const char *last, Index &dest)
+{
+    StructuralScanner scanner;
+    std::size_t size = last - first;
+    std::size_t offset = 0;
+
+    dest.reserve(size / 8);
+
+    for (; size - offset >= simd_block_size; offset += simd_block_size) {
+        append_structurals(
+            dest, offset, scanner.next(classify_block(first + offset)));
+    }
+
+    if (offset != size) {
+        char block[simd_block_size];
+
+        std::memset(block, ' ', simd_block_size);
+        std::memcpy(block, first + offset, size - offset);
+        append_structurals(dest, offset, scanner.next(classify_block(block)));
+    }
+}
+
+// Appends to `dest` the offsets of commas which separate the elements of the
+// array opening `[first, last)`, each the first such comma at least
+// `segment_size` bytes past the previous split.
+template <class Offsets>
+inline void find_array_splits(const char *first, const char *last,
+                              std::size_t segment_size, Offsets &dest)
+{
+    StructuralScanner scanner;
+    std::size_t size = last - first;
+    std::size_t next_split = segment_size;
+    std::ptrdiff_t depth = 0;
+
+    auto scan = [&](std::size_t offset, const char *block) {
+        BlockMasks masks = classify_block(block);
+        std::uint64_t bits = scanner.next(masks) & masks.op;
+
+        for (; bits; bits &= bits - 1) {
+            std::size_t pos = offset + std::countr_zero(bits);
+
+            switch (first[pos]) {
+            case '[':
+            case '{':
+                ++depth;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0) {
+                    next_split = std::numeric_limits<std::size_t>::max();
+                }
+                break;
+            case ',':
+                if (depth == 1 && pos >= next_split) {
+                    dest.push_back(pos);
+                    next_split = pos + segment_size;
+                }
+                break;
+            }
+        }
+    };
+
+    std::size_t offset = 0;
+
+    for (; size - offset >= simd_block_size; offset += simd_block_size) {
+        scan(offset, first + offset);
+    }
+
+    if (offset != size) {
+        char block[simd_block_size];
+
+        std::memset(block, ' ', simd_block_size);
+        std::memcpy(block, first + offset, size - offset);
+        scan(offset, block);
+    }
+}
+
+} // namespace htl::json::detail
+
+#endif
@@ -13,16 +13,24 @@
 #include <htl/detail/default_hash.h>
 #include <htl/detail/encoding.h>
 #include <htl/detail/json.h>
+#include <htl/detail/json_simd.h>
 #include <htl/detail/md4_state.h>
 #include <htl/detail/md5_state.h>
 #include <htl/detail/mdx_hash.h>
 #include <htl/detail/type_traits.h>
 #include <htl/json.h>
+#include <htl/json_arena.h>
+#include <htl/json_bind.h>
+#include <htl/json_lazy.h>
+#include <htl/json_parallel.h>
+#include <htl/json_pointer.h>
+#include <htl/json_writer.h>
 #include <htl/jsonfwd.h>
 #include <htl/math.h>
 #include <htl/md2.h>
 #include <htl/md4.h>
 #include <htl/md5.h>
+#include <htl/ndjson.h>
 #include <htl/rational.h>
 #include <htl/scope_guard.h>
 #include <htl/siphash.h>
@@ -7,9 +7,11 @@
 #ifndef HTL_JSON_H_
 #define HTL_JSON_H_
 
+#include <bit>
 #include <charconv>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <ios>
@@ -18,13 +20,18 @@
 #include <limits>
 #include <memory>
 #include <ranges>
+#include <source_location>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include <htl/ascii.h>
 #include <htl/concepts.h>
+#include <htl/detail/contract.h>
+#include <htl/detail/default_hash.h>
 #include <htl/detail/json.h>
 #include <htl/jsonfwd.h>
 #include <htl/utility.h>
@@ -36,7 +43,7 @@ class BasicDocument {
 public:
     using allocator_type = Alloc;
 
-    BasicDocument() noexcept(noexcept(Alloc()))
+    BasicDocument() noexcept(std::is_nothrow_default_constructible_v<Alloc>)
         : _type(Type::Null), _primitive()
     {}
 
@@ -168,7 +175,9 @@ public:
 
     ~BasicDocument() noexcept
     {
-        _destroy();
+        if constexpr (!detail::skips_destruction<Alloc>) {
+            _destroy();
+        }
     }
 
     BasicDocument &operator=(const BasicDocument &other)
@@ -316,8 +325,60 @@ public:
         return *_object;
     }
 
+    // Makes the document a string which refers to `value` instead of owning
+    // a copy, as `parse_in_situ` does. The characters must outlive the
+    // document and any copies of it. Strings too long to borrow are copied.
+    std::string_view emplace_borrowed_string(std::string_view value)
+    {
+        if (value.size() > std::numeric_limits<std::uint32_t>::max()) {
+            return emplace_string(value);
+        }
+
+        auto alloc = get_allocator();
+
+        _destroy();
+        _construct_at_primitive(alloc);
+        _primitive.get_string_data() = value.data();
+        _type = Type::String;
+        _is_borrowed = true;
+        _borrowed_size = static_cast<std::uint32_t>(value.size());
+        return value;
+    }
+
+    // Makes the document a number which refers to `text`, the text of a JSON
+    // number, and converts it only when read, as parsing with
+    // `ParseOptions::lazy_numbers` does. The characters must outlive the
+    // document and any copies of it. Text too long to borrow is converted.
+    void emplace_borrowed_number(std::string_view text)
+    {
+        bool is_int = text.find_first_of(".eE") == std::string_view::npos;
+
+        if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+            if (is_int) {
+                *this = detail::number_text_to_int(text);
+            } else {
+                *this = detail::number_text_to_float(text);
+            }
+
+            return;
+        }
+
+        auto alloc = get_allocator();
+
+        _destroy();
+        _construct_at_primitive(alloc);
+        _primitive.get_string_data() = text.data();
+        _type = is_int ? Type::Int : Type::Float;
+        _is_borrowed = true;
+        _borrowed_size = static_cast<std::uint32_t>(text.size());
+    }
+
     Alloc get_allocator() const noexcept
     {
+        if (_is_borrowed) {
+            return _primitive.get_allocator();
+        }
+
         switch (_type) {
         case Type::Null:
         case Type::Bool:
@@ -375,6 +436,13 @@ public:
         return type() == Type::Object;
     }
 
+    // Whether the document is a string or number which refers to characters
+    // it does not own.
+    bool is_borrowed() const noexcept
+    {
+        return _is_borrowed;
+    }
+
     Bool &get_bool() &noexcept
     {
         return _primitive.get_bool();
@@ -395,64 +463,118 @@ public:
         return std::move(_primitive.get_bool());
     }
 
+    // A borrowed number is first converted, and no longer keeps its text.
     Int &get_int() &noexcept
     {
+        _own_number();
         return _primitive.get_int();
     }
 
     Int &&get_int() &&noexcept
     {
+        _own_number();
         return std::move(_primitive.get_int());
     }
 
+    // Requires a converted number, as a borrowed number has no `Int` to refer
+    // to. This is checked in every build, aborting if the number is
+    // borrowed. `get_int_value` reads either.
     const Int &get_int() const &noexcept
     {
+        _expect_owned(std::source_location::current());
         return _primitive.get_int();
     }
 
     const Int &&get_int() const &&noexcept
     {
+        _expect_owned(std::source_location::current());
         return std::move(_primitive.get_int());
     }
 
+    // Value of a converted or a borrowed number. Borrowed numbers are
+    // converted on every call.
+    Int get_int_value() const noexcept
+    {
+        return _is_borrowed ? detail::number_text_to_int(get_number_text())
+                            : _primitive.get_int();
+    }
+
     Float &get_float() &noexcept
     {
+        _own_number();
         return _primitive.get_float();
     }
 
     Float &&get_float() &&noexcept
     {
+        _own_number();
         return std::move(_primitive.get_float());
     }
 
     const Float &get_float() const &noexcept
     {
+        _expect_owned(std::source_location::current());
         return _primitive.get_float();
     }
 
     const Float &&get_float() const &&noexcept
     {
+        _expect_owned(std::source_location::current());
         return std::move(_primitive.get_float());
     }
 
-    BasicString<Alloc> &get_string() &noexcept
+    Float get_float_value() const noexcept
     {
+        return _is_borrowed ? detail::number_text_to_float(get_number_text())
+                            : _primitive.get_float();
+    }
+
+    // Text of a borrowed number, or empty if the number is stored converted.
+    std::string_view get_number_text() const noexcept
+    {
+        if (_is_borrowed && (is_int() || is_float())) {
+            return { _primitive.get_string_data(), _borrowed_size };
+        }
+
+        return {};
+    }
+
+    // A borrowed string is first copied, so that it can be modified.
+    BasicString<Alloc> &get_string() &
+    {
+        _own_string();
         return *_string;
     }
 
-    BasicString<Alloc> &&get_string() &&noexcept
+    BasicString<Alloc> &&get_string() &&
     {
+        _own_string();
         return std::move(*_string);
     }
 
+    // Requires an owned string. Borrowed strings have no `BasicString` to
+    // refer to, and are only readable through `get_string_view`. This is
+    // checked in every build, aborting if the string is borrowed.
     const BasicString<Alloc> &get_string() const &noexcept
     {
+        _expect_owned(std::source_location::current());
         return *_string;
     }
 
     const BasicString<Alloc> &&get_string() const &&noexcept
     {
-        return *std::move(*_string);
+        _expect_owned(std::source_location::current());
+        return std::move(*_string);
+    }
+
+    // Characters of either an owned or a borrowed string.
+    std::string_view get_string_view() const noexcept
+    {
+        if (_is_borrowed) {
+            return { _primitive.get_string_data(), _borrowed_size };
+        }
+
+        return *_string;
     }
 
     BasicArray<Alloc> &get_array() &noexcept
@@ -515,11 +637,11 @@ public:
             case Type::Bool:
                 return a.get_bool() == b.get_bool();
             case Type::Int:
-                return a.get_int() == b.get_int();
+                return a.get_int_value() == b.get_int_value();
             case Type::Float:
-                return a.get_float() == b.get_float();
+                return a.get_float_value() == b.get_float_value();
             case Type::String:
-                return a.get_string() == b.get_string();
+                return a.get_string_view() == b.get_string_view();
             case Type::Array:
                 return a.get_array() == b.get_array();
             case Type::Object:
@@ -547,6 +669,12 @@ private:
     using Primitive = detail::Primitive<Alloc>;
 
     Type _type;
+
+    // Borrowed strings and numbers are stored as primitives, with the
+    // characters at `_primitive.get_string_data()`.
+    bool _is_borrowed = false;
+    std::uint32_t _borrowed_size = 0;
+
     union {
         Primitive _primitive;
         AllocatedPointer<BasicString<Alloc>> _string;
@@ -586,6 +714,11 @@ private:
 
     void _destroy() noexcept
     {
+        if (_is_borrowed) {
+            _destroy_at_primitive();
+            return;
+        }
+
         switch (_type) {
         case Type::Null:
         case Type::Bool:
@@ -654,6 +787,14 @@ private:
 
     void _copy_construct(const BasicDocument &other, const Alloc &alloc)
     {
+        if (other._is_borrowed) {
+            _construct_at_primitive(other._primitive, alloc);
+            _type = other._type;
+            _is_borrowed = true;
+            _borrowed_size = other._borrowed_size;
+            return;
+        }
+
         switch (other._type) {
         case Type::Null:
         case Type::Bool:
@@ -680,6 +821,15 @@ private:
 
     void _move_construct(BasicDocument &&other) noexcept
     {
+        _is_borrowed = std::exchange(other._is_borrowed, false);
+        _borrowed_size = other._borrowed_size;
+
+        if (_is_borrowed) {
+            _construct_at_primitive(other._primitive);
+            _type = std::exchange(other._type, Type::Null);
+            return;
+        }
+
         switch (other._type) {
         case Type::Null:
         case Type::Bool:
@@ -715,7 +865,7 @@ private:
         constexpr bool is_always_equal =
             std::allocator_traits<Alloc>::is_always_equal::value;
 
-        if (_type == other._type &&
+        if (_type == other._type && !_is_borrowed && !other._is_borrowed &&
             (is_always_equal || get_allocator() == other.get_allocator())) {
             switch (_type) {
             case Type::Null:
@@ -758,12 +908,14 @@ private:
         constexpr bool is_always_equal =
             std::allocator_traits<Alloc>::is_always_equal::value;
 
-        if (propagate || is_always_equal ||
-            get_allocator() == other.get_allocator()) {
+        if constexpr (propagate || is_always_equal) {
+            _destroy();
+            _move_construct(std::move(other));
+        } else if (get_allocator() == other.get_allocator()) {
             _destroy();
             _move_construct(std::move(other));
         } else {
-            auto alloc = propagate ? get_allocator() : other.get_allocator();
+            auto alloc = other.get_allocator();
             auto prev = std::move(*this);
 
             try {
@@ -778,6 +930,13 @@ private:
 
     void _assign_primitive(auto value, Type new_type) noexcept
     {
+        if (_is_borrowed) {
+            _primitive = value;
+            _type = new_type;
+            _is_borrowed = false;
+            return;
+        }
+
         switch (_type) {
         case Type::Null:
         case Type::Int:
@@ -801,7 +960,7 @@ private:
 
     void _assign_string(auto &&value)
     {
-        if (is_string()) {
+        if (is_string() && !_is_borrowed) {
             *_string = std::forward<decltype(value)>(value);
         } else {
             emplace_string(std::forward<decltype(value)>(value));
@@ -826,6 +985,32 @@ private:
         }
     }
 
+    void _own_string()
+    {
+        if (_is_borrowed) {
+            emplace_string(get_string_view());
+        }
+    }
+
+    void _expect_owned(const std::source_location &src) const noexcept
+    {
+        htl::detail::handle_contract(
+            !_is_borrowed, "!is_borrowed()", "precondition", src);
+    }
+
+    void _own_number() noexcept
+    {
+        if (!_is_borrowed) {
+            return;
+        } else if (is_int()) {
+            _assign_primitive(detail::number_text_to_int(get_number_text()),
+                              Type::Int);
+        } else {
+            _assign_primitive(
+                detail::number_text_to_float(get_number_text()), Type::Float);
+        }
+    }
+
     auto _release_string() noexcept
     {
         Alloc alloc(_string->get_allocator());
@@ -1634,7 +1819,9 @@ public:
 
     static constexpr size_type npos = Base::npos;
 
-    BasicString() noexcept(noexcept(Alloc())) : _base() {}
+    BasicString() noexcept(std::is_nothrow_default_constructible_v<Alloc>)
+        : _base()
+    {}
 
     explicit BasicString(const Alloc &alloc) noexcept : _base(alloc) {}
 
@@ -2651,8 +2838,9 @@ struct ParseError {
 public:
     ParseError() noexcept : ParseError(ParseErrorCode()) {}
 
-    ParseError(ParseErrorCode code, int line = -1, int column = -1) noexcept
-        : _code(code), _line(line), _column(column)
+    ParseError(ParseErrorCode code, int line = -1, int column = -1,
+               std::ptrdiff_t offset = -1) noexcept
+        : _code(code), _line(line), _column(column), _offset(offset)
     {}
 
     ParseErrorCode code() const noexcept
@@ -2670,6 +2858,14 @@ public:
         return _column;
     }
 
+    // Byte offset of the error from the start of the input. After a
+    // successful parse, the position is that of the end of the input
+    // consumed.
+    std::ptrdiff_t offset() const noexcept
+    {
+        return _offset;
+    }
+
     std::string_view message() const noexcept
     {
         switch (_code) {
@@ -2687,6 +2883,12 @@ public:
             return "number out of range";
         case ParseErrorCode::DuplicateKey:
             return "duplicate key";
+        case ParseErrorCode::Aborted:
+            return "aborted";
+        case ParseErrorCode::TypeMismatch:
+            return "type mismatch";
+        case ParseErrorCode::UnsupportedOption:
+            return "unsupported option";
         default:
             return {};
         }
@@ -2701,6 +2903,7 @@ private:
     ParseErrorCode _code;
     int _line;
     int _column;
+    std::ptrdiff_t _offset;
 };
 
 template <class I, class T>
@@ -2725,6 +2928,16 @@ struct ParseResult {
     }
 };
 
+template <class I>
+struct ParseEventsResult {
+    [[no_unique_address]] I in;
+    ParseError error;
+};
+
+// Result of `validate`, which produces no value.
+template <class I>
+using ValidateResult = ParseEventsResult<I>;
+
 template <class Alloc>
 class BasicParser {
 public:
@@ -2808,10 +3021,21 @@ public:
     ParseResult<I, BasicDocument<Alloc>>
     parse(I first, S last, const Alloc &alloc)
     {
-        detail::ParseHandler<I, S, Alloc> handler(
-            std::move(first), std::move(last), _alloc, alloc, _opts);
+        if constexpr (detail::contiguous_input<I, S>) {
+            const char *data = detail::to_char_pointer(first);
+            auto result = parse_contiguous(data, data + (last - first), alloc);
 
-        return handler.parse();
+            return {
+                std::move(first) + (result.in - data),
+                std::move(result.value),
+                result.error,
+            };
+        } else {
+            detail::ParseHandler<I, S, Alloc> handler(
+                std::move(first), std::move(last), _alloc, alloc, _opts);
+
+            return handler.parse();
+        }
     }
 
     template <std::ranges::input_range R>
@@ -2821,6 +3045,101 @@ public:
         return parse(std::ranges::begin(r), std::ranges::end(r), alloc);
     }
 
+    // Parses `input` in place: strings are unescaped within the buffer and
+    // borrowed by the document rather than copied, so the buffer must outlive
+    // the document. Object keys are still copied. The contents of `input` are
+    // unspecified afterwards, whether or not the parse succeeds.
+    ParseResult<char *, BasicDocument<Alloc>>
+    parse_in_situ(std::span<char> input)
+    {
+        return parse_in_situ(input, _alloc);
+    }
+
+    ParseResult<char *, BasicDocument<Alloc>>
+    parse_in_situ(std::span<char> input, const Alloc &alloc)
+    {
+        detail::ParseHandler<char *, char *, Alloc> handler(
+            input.data(), input.data() + input.size(), _alloc, alloc, _opts);
+
+        return handler.parse();
+    }
+
+    // Parses into calls to the members of `handler`: `on_null()`,
+    // `on_bool(Bool)`, `on_int(Int)`, `on_float(Float)`,
+    // `on_string(std::string_view)`, `on_key(std::string_view)`,
+    // `on_start_object()`, `on_end_object()`, `on_start_array()`, and
+    // `on_end_array()`. Any may be omitted, and returning false from one
+    // stops the parse with `ParseErrorCode::Aborted`. Views are only valid
+    // for the duration of the call. Duplicate keys are not detected.
+    template <std::input_iterator I, std::sentinel_for<I> S, class H>
+    ParseEventsResult<I> parse_events(I first, S last, H &&handler)
+    {
+        if constexpr (detail::contiguous_input<I, S>) {
+            const char *data = detail::to_char_pointer(first);
+            detail::EventParseHandler<const char *, const char *, Alloc, H>
+                event_handler(data, data + (last - first), handler, _alloc,
+                              _opts);
+            auto result = event_handler.parse();
+
+            return { std::move(first) + (result.in - data), result.error };
+        } else {
+            detail::EventParseHandler<I, S, Alloc, H> event_handler(
+                std::move(first), std::move(last), handler, _alloc, _opts);
+
+            return event_handler.parse();
+        }
+    }
+
+    template <std::ranges::input_range R, class H>
+    ParseEventsResult<std::ranges::borrowed_iterator_t<R>>
+    parse_events(R &&r, H &&handler)
+    {
+        return parse_events(
+            std::ranges::begin(r), std::ranges::end(r), handler);
+    }
+
+    // Checks that the input holds a document, as `parse` would, without
+    // building one, and returns the same error. Valid contiguous input is
+    // checked without allocating, unless it has comments, is nested more
+    // than 256 levels deep, or has more than 256 keys in its open objects
+    // while duplicate keys are rejected.
+    template <std::input_iterator I, std::sentinel_for<I> S>
+    ValidateResult<I> validate(I first, S last)
+    {
+        if constexpr (detail::contiguous_input<I, S>) {
+            const char *data = detail::to_char_pointer(first);
+
+            if (detail::BlockValidateHandler<Alloc> block_handler(
+                    data, data + (last - first), _alloc, _opts);
+                block_handler.validate()) {
+                auto pos = detail::locate(data, block_handler.end);
+                auto offset = block_handler.end - data;
+
+                return {
+                    std::move(first) + offset,
+                    { ParseErrorCode(), pos.line, pos.column, offset },
+                };
+            }
+
+            detail::ValidateHandler<const char *, const char *, Alloc> handler(
+                data, data + (last - first), _alloc, _opts);
+            auto result = handler.validate();
+
+            return { std::move(first) + (result.in - data), result.error };
+        } else {
+            detail::ValidateHandler<I, S, Alloc> handler(
+                std::move(first), std::move(last), _alloc, _opts);
+
+            return handler.validate();
+        }
+    }
+
+    template <std::ranges::input_range R>
+    ValidateResult<std::ranges::borrowed_iterator_t<R>> validate(R &&r)
+    {
+        return validate(std::ranges::begin(r), std::ranges::end(r));
+    }
+
     void swap(BasicParser &other) noexcept
     {
         using std::swap;
@@ -2834,12 +3153,26 @@ public:
 
     friend void swap(BasicParser &a, BasicParser &b) noexcept
     {
-        a.swa(b);
+        a.swap(b);
     }
 
 private:
     [[no_unique_address]] Alloc _alloc;
     ParseOptions _opts;
+
+    ParseResult<const char *, BasicDocument<Alloc>> parse_contiguous(
+        const char *first, const char *last, const Alloc &alloc)
+    {
+        if (auto result = detail::IndexParseHandler<Alloc>::parse(
+                first, last, _alloc, alloc, _opts)) {
+            return std::move(*result);
+        }
+
+        detail::ParseHandler<const char *, const char *, Alloc> handler(
+            first, last, _alloc, alloc, _opts);
+
+        return handler.parse();
+    }
 };
 
 template <std::input_iterator I, std::sentinel_for<I> S, class Alloc>
@@ -2847,7 +3180,7 @@ template <std::input_iterator I, std::sentinel_for<I> S, class Alloc>
 inline ParseResult<I, BasicDocument<Alloc>> parse(
     I first, S last, const Alloc &alloc)
 {
-    return parse(std::move(first), std::move(last), {}, alloc);
+    return parse(std::move(first), std::move(last), ParseOptions(), alloc);
 }
 
 template <std::input_iterator I, std::sentinel_for<I> S,
@@ -2864,7 +3197,7 @@ template <std::ranges::input_range R, class Alloc>
 inline ParseResult<std::ranges::borrowed_iterator_t<R>,
                    BasicDocument<Alloc>> parse(R &&r, const Alloc &alloc)
 {
-    return parse(std::forward<R>(r), {}, alloc);
+    return parse(std::forward<R>(r), ParseOptions(), alloc);
 }
 
 template <std::ranges::input_range R, class Alloc = std::allocator<std::byte>>
@@ -2875,6 +3208,229 @@ parse(R &&r, const ParseOptions &opts = ParseOptions(),
     return parse(std::ranges::begin(r), std::ranges::end(r), opts, alloc);
 }
 
+template <class Alloc = std::allocator<std::byte>>
+inline ParseResult<char *, BasicDocument<Alloc>>
+parse_in_situ(std::span<char> input, const ParseOptions &opts = ParseOptions(),
+              const Alloc &alloc = Alloc())
+{
+    return BasicParser(opts, alloc).parse_in_situ(input);
+}
+
+template <std::input_iterator I, std::sentinel_for<I> S, class H,
+          class Alloc = std::allocator<std::byte>>
+inline ParseEventsResult<I> parse_events(
+    I first, S last, H &&handler, const ParseOptions &opts = ParseOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicParser(opts, alloc).parse_events(
+        std::move(first), std::move(last), handler);
+}
+
+template <std::ranges::input_range R, class H,
+          class Alloc = std::allocator<std::byte>>
+inline ParseEventsResult<std::ranges::borrowed_iterator_t<R>> parse_events(
+    R &&r, H &&handler, const ParseOptions &opts = ParseOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return parse_events(
+        std::ranges::begin(r), std::ranges::end(r), handler, opts, alloc);
+}
+
+template <std::input_iterator I, std::sentinel_for<I> S,
+          class Alloc = std::allocator<std::byte>>
+inline ValidateResult<I> validate(I first, S last,
+                                  const ParseOptions &opts = ParseOptions(),
+                                  const Alloc &alloc = Alloc())
+{
+    return BasicParser(opts, alloc).validate(std::move(first), std::move(last));
+}
+
+template <std::ranges::input_range R, class Alloc = std::allocator<std::byte>>
+inline ValidateResult<std::ranges::borrowed_iterator_t<R>>
+validate(R &&r, const ParseOptions &opts = ParseOptions(),
+         const Alloc &alloc = Alloc())
+{
+    return validate(std::ranges::begin(r), std::ranges::end(r), opts, alloc);
+}
+
+// Parses a document from input which arrives in chunks. Each call to
+// `feed()` parses as far as the chunk allows and keeps only an incomplete
+// trailing token, so the input never needs to be held in full. Input after
+// the end of the document is ignored.
+template <class Alloc>
+class BasicIncrementalParser {
+public:
+    BasicIncrementalParser() noexcept(noexcept(Alloc()))
+        : BasicIncrementalParser(ParseOptions())
+    {}
+
+    explicit BasicIncrementalParser(const Alloc &alloc)
+        : BasicIncrementalParser(ParseOptions(), alloc)
+    {}
+
+    explicit BasicIncrementalParser(
+        const ParseOptions &opts, const Alloc &alloc = Alloc())
+        : _alloc(alloc), _opts(opts), _handler(nullptr, nullptr, alloc, alloc,
+                                               opts),
+          _value(alloc), _buffer(alloc)
+    {
+        // Chunks need not outlive the parse, so numbers are always converted.
+        _opts.lazy_numbers = false;
+        _handler.opts.lazy_numbers = false;
+    }
+
+    BasicIncrementalParser(const BasicIncrementalParser &) = delete;
+
+    BasicIncrementalParser &operator=(const BasicIncrementalParser &) = delete;
+
+    Alloc get_allocator() noexcept
+    {
+        return _alloc;
+    }
+
+    ParseOptions get_options() noexcept
+    {
+        return _opts;
+    }
+
+    // Whether the document has been parsed in full.
+    bool complete() const noexcept
+    {
+        return _started && _handler.stack.empty() && !_error;
+    }
+
+    // Parses the next chunk of input. Returns the first error found, which
+    // stops all further parsing.
+    ParseError feed(std::span<const char> chunk)
+    {
+        if (_error || complete()) {
+            return _error;
+        }
+
+        if (_buffer.empty()) {
+            const char *pos = run(chunk.data(), chunk.data() + chunk.size());
+            const char *end = chunk.data() + chunk.size();
+
+            if (!_error && !complete()) {
+                _buffer.assign(pos, end);
+            }
+        } else {
+            _buffer.insert(_buffer.end(), chunk.begin(), chunk.end());
+
+            const char *data = _buffer.data();
+            const char *pos = run(data, data + _buffer.size());
+
+            if (_error || complete()) {
+                _buffer.clear();
+            } else {
+                _buffer.erase(_buffer.begin(), _buffer.begin() + (pos - data));
+            }
+        }
+
+        return _error;
+    }
+
+    // Parses the remaining input and returns the document, with the number
+    // of bytes it spans in place of an iterator. Resets the parser.
+    ParseResult<std::size_t, BasicDocument<Alloc>> finish()
+    {
+        if (!_error && !complete()) {
+            run(_buffer.data(), _buffer.data() + _buffer.size(), true);
+        }
+
+        ParseResult<std::size_t, BasicDocument<Alloc>> result{
+            static_cast<std::size_t>(_error ? _error.offset() : _offset),
+            std::move(_value),
+            _error ? _error
+                   : ParseError(ParseErrorCode(), _position.line,
+                                _position.column, _offset),
+        };
+
+        reset();
+        return result;
+    }
+
+    void reset()
+    {
+        _handler = Handler(nullptr, nullptr, _alloc, _alloc, _opts);
+        _scanner = {};
+        _value = nullptr;
+        _buffer.clear();
+        _error = {};
+        _position = {};
+        _offset = 0;
+        _started = false;
+    }
+
+private:
+    using Handler = detail::ParseHandler<const char *, const char *, Alloc>;
+    using Buffer = std::vector<
+        char, typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+
+    [[no_unique_address]] Alloc _alloc;
+    ParseOptions _opts;
+    Handler _handler;
+    detail::StepScanner _scanner;
+    BasicDocument<Alloc> _value;
+    Buffer _buffer;
+    ParseError _error;
+    detail::TextPosition _position{};
+    std::size_t _offset = 0;
+    bool _started = false;
+
+    // Parses every complete step of `[first, last)`, or everything if
+    // `final`, and returns the end of the input consumed.
+    const char *run(const char *first, const char *last, bool final = false)
+    {
+        _handler.first = first;
+        _handler.last = last;
+        _handler.start = first;
+
+        while (!_handler.has_error() && !complete()) {
+            if (!final && !_scanner.scan(_handler.first, last, _opts)) {
+                break;
+            }
+
+            _scanner = {};
+            step();
+        }
+
+        if (_handler.has_error()) {
+            _handler.locate_position();
+            _error = ParseError(_handler.code, _position.line +
+                                                   _handler.line,
+                                _handler.line ? _handler.column
+                                              : _position.column +
+                                                    _handler.column,
+                                _offset + _handler.offset);
+            return _handler.first;
+        }
+
+        auto pos = detail::locate(first, _handler.first);
+
+        if (pos.line) {
+            _position = { _position.line + pos.line, pos.column };
+        } else {
+            _position.column += pos.column;
+        }
+
+        _offset += _handler.first - first;
+        return _handler.first;
+    }
+
+    void step()
+    {
+        if (!_started) {
+            _started = true;
+            _handler.start_document(_value);
+        } else if (_handler.stack.size() > _opts.max_depth) {
+            _handler.set_max_depth();
+        } else {
+            _handler.continue_document(*_handler.stack.back());
+        }
+    }
+};
+
 template <class Alloc>
 class BasicSerializer {
 public:
@@ -2987,6 +3543,50 @@ public:
         return _serialize(value, std::move(out));
     }
 
+    std::size_t serialized_size(const BasicDocument<Alloc> &value)
+    {
+        return _serialize(value, detail::SizeCounter()).size;
+    }
+
+    std::size_t serialized_size(const BasicString<Alloc> &value)
+    {
+        return _serialize(value, detail::SizeCounter()).size;
+    }
+
+    std::size_t serialized_size(const BasicArray<Alloc> &value)
+    {
+        return _serialize(value, detail::SizeCounter()).size;
+    }
+
+    std::size_t serialized_size(const BasicObject<Alloc> &value)
+    {
+        return _serialize(value, detail::SizeCounter()).size;
+    }
+
+    std::to_chars_result serialize_to(
+        const BasicDocument<Alloc> &value, std::span<char> dest)
+    {
+        return _serialize_to(value, dest);
+    }
+
+    std::to_chars_result serialize_to(
+        const BasicString<Alloc> &value, std::span<char> dest)
+    {
+        return _serialize_to(value, dest);
+    }
+
+    std::to_chars_result serialize_to(
+        const BasicArray<Alloc> &value, std::span<char> dest)
+    {
+        return _serialize_to(value, dest);
+    }
+
+    std::to_chars_result serialize_to(
+        const BasicObject<Alloc> &value, std::span<char> dest)
+    {
+        return _serialize_to(value, dest);
+    }
+
     void swap(BasicSerializer &other) noexcept
     {
         using std::swap;
@@ -3013,7 +3613,188 @@ private:
         detail::SerializeHandler<O, Alloc> handler(
             std::move(out), _alloc, _opts);
         handler.serialize(value);
-        return std::move(handler.out);
+        return handler.out.release();
+    }
+
+    template <class T>
+    std::to_chars_result _serialize_to(const T &value, std::span<char> dest)
+    {
+        detail::BoundedOutput out{ dest.data(), dest.data() + dest.size() };
+
+        out = _serialize(value, out);
+
+        if (out.overflow) {
+            return { out.end, std::errc::value_too_large };
+        }
+
+        return { out.pos, std::errc() };
+    }
+};
+
+// Serializes a document a chunk at a time into buffers supplied by the
+// caller, so output can be streamed with a fixed buffer. Between calls only
+// the position within the document is kept, along with the part of the last
+// token which did not fit, so at most one string of the document is held in
+// full. The document must outlive the serializer and not change while in use.
+template <class Alloc>
+class BasicChunkedSerializer {
+public:
+    class ChunkRange;
+
+    explicit BasicChunkedSerializer(
+        const BasicDocument<Alloc> &value,
+        const SerializeOptions &opts = SerializeOptions(),
+        const Alloc &alloc = Alloc())
+        : _value(std::addressof(value)), _overflow(alloc),
+          _handler(Output{ nullptr, nullptr, &_overflow }, alloc, opts),
+          _overflow_pos(0), _started(false)
+    {}
+
+    BasicChunkedSerializer(const BasicChunkedSerializer &) = delete;
+
+    BasicChunkedSerializer &operator=(const BasicChunkedSerializer &) = delete;
+
+    // Whether all of the output has been returned.
+    bool done() const noexcept
+    {
+        return _started && _handler.stack.empty() &&
+               _overflow_pos == _overflow.size();
+    }
+
+    // Writes the next part of the output to `dest`, filling it unless the
+    // output ends first. Returns the number of characters written, which for
+    // a non-empty `dest` is 0 only once `done()`.
+    std::size_t next_chunk(std::span<char> dest)
+    {
+        auto &out = _handler.out.dest;
+        std::size_t size =
+            std::min(_overflow.size() - _overflow_pos, dest.size());
+
+        std::ranges::copy_n(_overflow.data() + _overflow_pos, size,
+                            dest.data());
+        _overflow_pos += size;
+        out.pos = dest.data() + size;
+        out.end = dest.data() + dest.size();
+
+        if (_overflow_pos == _overflow.size()) {
+            _overflow.clear();
+            _overflow_pos = 0;
+
+            while (out.pos != out.end && _step()) {
+            }
+        }
+
+        return out.pos - dest.data();
+    }
+
+    // The remaining output as a range of `std::string_view` chunks, each
+    // written to `buffer` and valid until the next is read.
+    ChunkRange chunks(std::span<char> buffer) noexcept
+    {
+        return ChunkRange(*this, buffer);
+    }
+
+private:
+    using Output = detail::ChunkOutput<Alloc>;
+
+    const BasicDocument<Alloc> *_value;
+    typename Output::Overflow _overflow;
+    detail::SerializeHandler<Output, Alloc> _handler;
+    std::size_t _overflow_pos;
+    bool _started;
+
+    // Writes the next token, returning false once there are none left.
+    bool _step()
+    {
+        if (!_started) {
+            _started = true;
+            _handler.start_document(*_value);
+        } else if (_handler.stack.size()) {
+            _handler.continue_document(_handler.stack.back());
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+};
+
+template <class Alloc>
+class BasicChunkedSerializer<Alloc>::ChunkRange {
+public:
+    class iterator {
+    public:
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() noexcept = default;
+
+        const std::string_view &operator*() const noexcept
+        {
+            return _range->_chunk;
+        }
+
+        const std::string_view *operator->() const noexcept
+        {
+            return std::addressof(_range->_chunk);
+        }
+
+        iterator &operator++()
+        {
+            _range->_next();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            ++*this;
+        }
+
+        friend bool operator==(
+            const iterator &it, std::default_sentinel_t) noexcept
+        {
+            return it._done();
+        }
+
+    private:
+        friend class ChunkRange;
+
+        ChunkRange *_range = nullptr;
+
+        explicit iterator(ChunkRange *range) noexcept : _range(range) {}
+
+        bool _done() const noexcept
+        {
+            return _range->_chunk.empty();
+        }
+    };
+
+    ChunkRange(BasicChunkedSerializer &serializer,
+               std::span<char> buffer) noexcept
+        : _serializer(std::addressof(serializer)), _buffer(buffer), _chunk()
+    {}
+
+    iterator begin()
+    {
+        _next();
+        return iterator(this);
+    }
+
+    std::default_sentinel_t end() const noexcept
+    {
+        return std::default_sentinel;
+    }
+
+private:
+    BasicChunkedSerializer *_serializer;
+    std::span<char> _buffer;
+    std::string_view _chunk;
+
+    void _next()
+    {
+        _chunk = std::string_view(
+            _buffer.data(), _serializer->next_chunk(_buffer));
     }
 };
 
@@ -3135,6 +3916,94 @@ inline O serialize(
     return BasicSerializer(opts, alloc).serialize(value, std::move(out));
 }
 
+// Length of the output of `serialize` for `value`.
+template <class Alloc>
+inline std::size_t serialized_size(
+    const BasicDocument<Alloc> &value,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialized_size(value);
+}
+
+// Serializes `value` into `dest`. Fails with `std::errc::value_too_large` if
+// `dest` is shorter than `serialized_size(value)`, with its contents left
+// unspecified.
+template <class Alloc>
+inline std::to_chars_result serialize_to(
+    const BasicDocument<Alloc> &value, std::span<char> dest,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialize_to(value, dest);
+}
+
+// Length of the output of `serialize` for `value`.
+template <class Alloc>
+inline std::size_t serialized_size(
+    const BasicString<Alloc> &value,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialized_size(value);
+}
+
+// Serializes `value` into `dest`. Fails with `std::errc::value_too_large` if
+// `dest` is shorter than `serialized_size(value)`, with its contents left
+// unspecified.
+template <class Alloc>
+inline std::to_chars_result serialize_to(
+    const BasicString<Alloc> &value, std::span<char> dest,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialize_to(value, dest);
+}
+
+// Length of the output of `serialize` for `value`.
+template <class Alloc>
+inline std::size_t serialized_size(
+    const BasicArray<Alloc> &value,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialized_size(value);
+}
+
+// Serializes `value` into `dest`. Fails with `std::errc::value_too_large` if
+// `dest` is shorter than `serialized_size(value)`, with its contents left
+// unspecified.
+template <class Alloc>
+inline std::to_chars_result serialize_to(
+    const BasicArray<Alloc> &value, std::span<char> dest,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialize_to(value, dest);
+}
+
+// Length of the output of `serialize` for `value`.
+template <class Alloc>
+inline std::size_t serialized_size(
+    const BasicObject<Alloc> &value,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialized_size(value);
+}
+
+// Serializes `value` into `dest`. Fails with `std::errc::value_too_large` if
+// `dest` is shorter than `serialized_size(value)`, with its contents left
+// unspecified.
+template <class Alloc>
+inline std::to_chars_result serialize_to(
+    const BasicObject<Alloc> &value, std::span<char> dest,
+    const SerializeOptions &opts = SerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return BasicSerializer(opts, alloc).serialize_to(value, dest);
+}
+
 template <std::output_iterator<char> O, class Alloc>
 inline O to_chars(const BasicDocument<Alloc> &value, O out)
 {
@@ -3163,8 +4032,11 @@ template <class Alloc = std::allocator<char>, class ValueAlloc>
 inline std::basic_string<char, std::char_traits<char>, Alloc>
 to_string(const BasicDocument<ValueAlloc> &value, const Alloc &alloc = Alloc())
 {
-    std::basic_string<char, std::char_traits<char>, Alloc> dest(alloc);
-    to_chars(value, std::back_inserter(dest));
+    BasicSerializer<ValueAlloc> serializer(value.get_allocator());
+    std::basic_string<char, std::char_traits<char>, Alloc> dest(
+        serializer.serialized_size(value), '\0', alloc);
+
+    serializer.serialize(value, dest.data());
     return dest;
 }
 
@@ -3172,8 +4044,11 @@ template <class Alloc = std::allocator<char>, class ValueAlloc>
 inline std::basic_string<char, std::char_traits<char>, Alloc>
 to_string(const BasicString<ValueAlloc> &value, const Alloc &alloc = Alloc())
 {
-    std::basic_string<char, std::char_traits<char>, Alloc> dest(alloc);
-    to_chars(value, std::back_inserter(dest));
+    BasicSerializer<ValueAlloc> serializer(value.get_allocator());
+    std::basic_string<char, std::char_traits<char>, Alloc> dest(
+        serializer.serialized_size(value), '\0', alloc);
+
+    serializer.serialize(value, dest.data());
     return dest;
 }
 
@@ -3181,8 +4056,11 @@ template <class Alloc = std::allocator<char>, class ValueAlloc>
 inline std::basic_string<char, std::char_traits<char>, Alloc>
 to_string(const BasicArray<ValueAlloc> &value, const Alloc &alloc = Alloc())
 {
-    std::basic_string<char, std::char_traits<char>, Alloc> dest(alloc);
-    to_chars(value, std::back_inserter(dest));
+    BasicSerializer<ValueAlloc> serializer(value.get_allocator());
+    std::basic_string<char, std::char_traits<char>, Alloc> dest(
+        serializer.serialized_size(value), '\0', alloc);
+
+    serializer.serialize(value, dest.data());
     return dest;
 }
 
@@ -3190,8 +4068,11 @@ template <class Alloc = std::allocator<char>, class ValueAlloc>
 inline std::basic_string<char, std::char_traits<char>, Alloc>
 to_string(const BasicObject<ValueAlloc> &value, const Alloc &alloc = Alloc())
 {
-    std::basic_string<char, std::char_traits<char>, Alloc> dest(alloc);
-    to_chars(value, std::back_inserter(dest));
+    BasicSerializer<ValueAlloc> serializer(value.get_allocator());
+    std::basic_string<char, std::char_traits<char>, Alloc> dest(
+        serializer.serialized_size(value), '\0', alloc);
+
+    serializer.serialize(value, dest.data());
     return dest;
 }
 
@@ -3200,7 +4081,12 @@ inline std::basic_ostream<CharT, Traits> &operator<<(
     std::basic_ostream<CharT, Traits> &stream,
     const BasicDocument<Alloc> &value)
 {
-    to_chars(value, std::ostream_iterator<char>(stream));
+    if (typename std::basic_ostream<CharT, Traits>::sentry sentry(stream);
+        sentry &&
+        to_chars(value, detail::StreambufOutput{ stream.rdbuf() }).failed) {
+        stream.setstate(std::ios::badbit);
+    }
+
     return stream;
 }
 
@@ -3208,7 +4094,12 @@ template <class CharT, class Traits, class Alloc>
 inline std::basic_ostream<CharT, Traits> &operator<<(
     std::basic_ostream<CharT, Traits> &stream, const BasicString<Alloc> &value)
 {
-    to_chars(value, std::ostream_iterator<char>(stream));
+    if (typename std::basic_ostream<CharT, Traits>::sentry sentry(stream);
+        sentry &&
+        to_chars(value, detail::StreambufOutput{ stream.rdbuf() }).failed) {
+        stream.setstate(std::ios::badbit);
+    }
+
     return stream;
 }
 
@@ -3216,7 +4107,12 @@ template <class CharT, class Traits, class Alloc>
 inline std::basic_ostream<CharT, Traits> &operator<<(
     std::basic_ostream<CharT, Traits> &stream, const BasicArray<Alloc> &value)
 {
-    to_chars(value, std::ostream_iterator<char>(stream));
+    if (typename std::basic_ostream<CharT, Traits>::sentry sentry(stream);
+        sentry &&
+        to_chars(value, detail::StreambufOutput{ stream.rdbuf() }).failed) {
+        stream.setstate(std::ios::badbit);
+    }
+
     return stream;
 }
 
@@ -3224,7 +4120,12 @@ template <class CharT, class Traits, class Alloc>
 inline std::basic_ostream<CharT, Traits> &operator<<(
     std::basic_ostream<CharT, Traits> &stream, const BasicObject<Alloc> &value)
 {
-    to_chars(value, std::ostream_iterator<char>(stream));
+    if (typename std::basic_ostream<CharT, Traits>::sentry sentry(stream);
+        sentry &&
+        to_chars(value, detail::StreambufOutput{ stream.rdbuf() }).failed) {
+        stream.setstate(std::ios::badbit);
+    }
+
     return stream;
 }
 
@@ -3313,6 +4214,208 @@ operator>>(std::basic_istream<CharT, Traits> &stream, BasicObject<Alloc> &dest)
     return stream;
 }
 
+namespace detail {
+
+template <class H>
+inline void hash_u64(H &hasher, std::uint64_t value)
+{
+    std::uint8_t bytes[8];
+
+    store_unaligned_le64(bytes, value);
+    hasher.update(bytes, sizeof(bytes));
+}
+
+template <class H>
+inline void hash_tag(H &hasher, Type type)
+{
+    auto tag = static_cast<std::uint8_t>(type);
+    hasher.update(&tag, 1);
+}
+
+template <class H>
+inline void hash_string(H &hasher, std::string_view value)
+{
+    hash_tag(hasher, Type::String);
+    hash_u64(hasher, value.size());
+    hasher.update(reinterpret_cast<const std::uint8_t *>(value.data()),
+                  value.size());
+}
+
+template <class H, class Alloc>
+inline void hash_document(H &hasher, const BasicDocument<Alloc> &value);
+
+template <class H, class Alloc>
+inline void hash_array(H &hasher, const BasicArray<Alloc> &value)
+{
+    hash_tag(hasher, Type::Array);
+    hash_u64(hasher, value.size());
+
+    for (auto &element: value) {
+        hash_document(hasher, element);
+    }
+}
+
+// Members are hashed separately, each starting from the state after the size
+// of the object, and their digests summed so that the order of iteration has
+// no effect.
+template <class H, class Alloc>
+inline void hash_object(H &hasher, const BasicObject<Alloc> &value)
+{
+    static_assert(H::digest_size % 8 == 0);
+
+    constexpr std::size_t word_count = H::digest_size / 8;
+
+    hash_tag(hasher, Type::Object);
+    hash_u64(hasher, value.size());
+
+    const H initial = hasher;
+    std::uint64_t sum[word_count]{};
+
+    for (auto &[key, member]: value) {
+        H member_hasher = initial;
+        std::uint8_t digest[H::digest_size];
+
+        hash_string(member_hasher, key);
+        hash_document(member_hasher, member);
+        member_hasher.finalize(digest);
+
+        for (std::size_t i = 0; i < word_count; ++i) {
+            sum[i] += load_unaligned_le64(digest + 8 * i);
+        }
+    }
+
+    for (auto word: sum) {
+        hash_u64(hasher, word);
+    }
+}
+
+template <class H, class Alloc>
+inline void hash_document(H &hasher, const BasicDocument<Alloc> &value)
+{
+    switch (value.type()) {
+    case Type::Null:
+        hash_tag(hasher, Type::Null);
+        break;
+    case Type::Bool:
+        hash_tag(hasher, Type::Bool);
+        hash_u64(hasher, value.get_bool());
+        break;
+    case Type::Int:
+        hash_tag(hasher, Type::Int);
+        hash_u64(hasher, static_cast<std::uint64_t>(value.get_int_value()));
+        break;
+    case Type::Float:
+        // Zeros compare equal whatever their sign.
+        hash_tag(hasher, Type::Float);
+        hash_u64(hasher,
+                 value.get_float_value() == 0
+                     ? 0
+                     : std::bit_cast<std::uint64_t>(value.get_float_value()));
+        break;
+    case Type::String:
+        hash_string(hasher, value.get_string_view());
+        break;
+    case Type::Array:
+        hash_array(hasher, value.get_array());
+        break;
+    case Type::Object:
+        hash_object(hasher, value.get_object());
+        break;
+    }
+}
+
+} // namespace detail
+
+// Feeds the structure of `value` to the hash context `hasher`, such as
+// `SipHash` or `MD5`, without serializing it. Values which compare equal feed
+// the same bytes, whatever the order of object members and however strings
+// and numbers are stored. `H` must be copyable and have a `digest_size`
+// which is a multiple of 8.
+template <class H, class Alloc>
+inline void hash_append(H &hasher, const BasicDocument<Alloc> &value)
+{
+    detail::hash_document(hasher, value);
+}
+
+template <class H, class Alloc>
+inline void hash_append(H &hasher, const BasicArray<Alloc> &value)
+{
+    detail::hash_array(hasher, value);
+}
+
+template <class H, class Alloc>
+inline void hash_append(H &hasher, const BasicObject<Alloc> &value)
+{
+    detail::hash_object(hasher, value);
+}
+
+template <class Alloc>
+inline std::uint64_t hash(const BasicDocument<Alloc> &value) noexcept
+{
+    htl::detail::DefaultHasher hasher;
+
+    hash_append(hasher, value);
+    return hasher.digest();
+}
+
+template <class Alloc>
+inline std::uint64_t hash(const BasicArray<Alloc> &value) noexcept
+{
+    htl::detail::DefaultHasher hasher;
+
+    hash_append(hasher, value);
+    return hasher.digest();
+}
+
+template <class Alloc>
+inline std::uint64_t hash(const BasicObject<Alloc> &value) noexcept
+{
+    htl::detail::DefaultHasher hasher;
+
+    hash_append(hasher, value);
+    return hasher.digest();
+}
+
 } // namespace htl::json
 
+namespace std {
+
+template <class Alloc>
+struct hash<htl::json::BasicDocument<Alloc>> {
+    std::size_t operator()(
+        const htl::json::BasicDocument<Alloc> &value) const noexcept
+    {
+        return htl::json::hash(value);
+    }
+};
+
+template <class Alloc>
+struct hash<htl::json::BasicString<Alloc>> {
+    std::size_t operator()(
+        const htl::json::BasicString<Alloc> &value) const noexcept
+    {
+        return hash<std::string_view>()(value);
+    }
+};
+
+template <class Alloc>
+struct hash<htl::json::BasicArray<Alloc>> {
+    std::size_t operator()(
+        const htl::json::BasicArray<Alloc> &value) const noexcept
+    {
+        return htl::json::hash(value);
+    }
+};
+
+template <class Alloc>
+struct hash<htl::json::BasicObject<Alloc>> {
+    std::size_t operator()(
+        const htl::json::BasicObject<Alloc> &value) const noexcept
+    {
+        return htl::json::hash(value);
+    }
+};
+
+} // namespace std
+
 #endif
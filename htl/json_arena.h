@@ -0,0 +1,287 @@
+/**
+ * @file htl/json_arena.h
+ *
+ * Bump pointer arena for JSON documents
+ */
+
+#ifndef HTL_JSON_ARENA_H_
+#define HTL_JSON_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <htl/config.h>
+#include <htl/json.h>
+
+#if HTL_LINUX
+#include <sys/mman.h>
+#endif
+
+namespace htl::json {
+
+struct ArenaOptions {
+    // Size of the first block. Each further block is twice the size of the
+    // last, up to `max_block_size`, or larger if a single allocation needs it.
+    std::size_t initial_block_size = std::size_t(1) << 16;
+    std::size_t max_block_size = std::size_t(1) << 26;
+
+    // Align blocks to huge pages and ask for them to be backed by huge pages,
+    // where the system supports it.
+    bool huge_pages = false;
+};
+
+// Memory handed out by advancing a pointer through a list of blocks. Memory
+// is only reclaimed by `reset()`, which keeps the blocks for reuse, or by
+// `release()`. Once a workload has grown the blocks it needs, a loop which
+// calls `reset()` between iterations allocates nothing from the system.
+class Arena {
+public:
+    Arena() noexcept : Arena(ArenaOptions()) {}
+
+    explicit Arena(const ArenaOptions &opts) noexcept
+        : _opts(opts), _first(nullptr), _current(nullptr), _pos(0), _end(0),
+          _next_block_size(opts.initial_block_size)
+    {}
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena()
+    {
+        release();
+    }
+
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        std::uintptr_t pos = (_pos + alignment - 1) & ~(alignment - 1);
+
+        if (pos >= _pos && pos <= _end && size <= _end - pos) {
+            _pos = pos + size;
+            return reinterpret_cast<void *>(pos);
+        }
+
+        return _allocate_slow(size, alignment);
+    }
+
+    // Reclaims `p` only if it is the most recent allocation, which lets a
+    // growing vector at the end of the arena reuse its old storage.
+    void deallocate(void *p, std::size_t size) noexcept
+    {
+        if (reinterpret_cast<std::uintptr_t>(p) + size == _pos) {
+            _pos = reinterpret_cast<std::uintptr_t>(p);
+        }
+    }
+
+    // Makes all memory available again, keeping every block. Anything still
+    // allocated in the arena must no longer be used.
+    void reset() noexcept
+    {
+        _use(_first);
+    }
+
+    // Returns every block to the system.
+    void release() noexcept
+    {
+        while (_first) {
+            Block *next = _first->next;
+
+            ::operator delete(static_cast<void *>(_first), _first->size,
+                              std::align_val_t(_block_alignment()));
+            _first = next;
+        }
+
+        _current = nullptr;
+        _pos = _end = 0;
+        _next_block_size = _opts.initial_block_size;
+    }
+
+    // Total size of the blocks held.
+    std::size_t capacity() const noexcept
+    {
+        std::size_t size = 0;
+
+        for (Block *block = _first; block; block = block->next) {
+            size += block->size - sizeof(Block);
+        }
+
+        return size;
+    }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        Block *next;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t huge_page_size = std::size_t(1) << 21;
+
+    ArenaOptions _opts;
+    Block *_first;
+    Block *_current;
+    std::uintptr_t _pos;
+    std::uintptr_t _end;
+    std::size_t _next_block_size;
+
+    std::size_t _block_alignment() const noexcept
+    {
+        return _opts.huge_pages ? huge_page_size : alignof(Block);
+    }
+
+    void _use(Block *block) noexcept
+    {
+        _current = block;
+
+        if (block) {
+            _pos = reinterpret_cast<std::uintptr_t>(block + 1);
+            _end = reinterpret_cast<std::uintptr_t>(block) + block->size;
+        } else {
+            _pos = _end = 0;
+        }
+    }
+
+    void *_allocate_slow(std::size_t size, std::size_t alignment)
+    {
+        if (size > std::numeric_limits<std::size_t>::max() / 2 - alignment) {
+            throw std::bad_alloc();
+        }
+
+        // Room for the block header and the worst case of alignment.
+        std::size_t needed = sizeof(Block) + size + alignment;
+
+        if (_current && _current->next && _current->next->size >= needed) {
+            _use(_current->next);
+        } else {
+            _use(_new_block(needed));
+        }
+
+        return allocate(size, alignment);
+    }
+
+    // Allocates a block of at least `needed` bytes and links it after the
+    // current block, ahead of any kept by `reset()`.
+    Block *_new_block(std::size_t needed)
+    {
+        std::size_t size = std::max(needed, _next_block_size);
+
+        if (_opts.huge_pages) {
+            size = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+        }
+
+        void *p = ::operator new(size, std::align_val_t(_block_alignment()));
+
+#if HTL_LINUX && defined(MADV_HUGEPAGE)
+        if (_opts.huge_pages) {
+            ::madvise(p, size, MADV_HUGEPAGE);
+        }
+#endif
+
+        Block *block = ::new (p) Block{ nullptr, size };
+
+        if (_current) {
+            block->next = _current->next;
+            _current->next = block;
+        } else {
+            block->next = _first;
+            _first = block;
+        }
+
+        _next_block_size =
+            std::min(_opts.max_block_size,
+                     std::max(_next_block_size, _next_block_size * 2));
+        return block;
+    }
+};
+
+// Allocator which takes its memory from an `Arena` and never frees it, other
+// than the most recent allocation. Documents using it destroy nothing when
+// they are destroyed, see `detail::skips_destruction`.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena &arena) noexcept : _arena(std::addressof(arena)) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+        : _arena(other.arena())
+    {}
+
+    T *allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+
+        return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        _arena->deallocate(p, n * sizeof(T));
+    }
+
+    // Values made without arguments, such as the elements a parser adds to
+    // an array, take their allocator from the container, as there is no
+    // default arena.
+    template <class U, class... Args>
+    void construct(U *p, Args &&...args)
+    {
+        if constexpr (!sizeof...(Args) &&
+                      std::is_constructible_v<U, const ArenaAllocator &>) {
+            ::new (static_cast<void *>(p)) U(*this);
+        } else {
+            ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+    }
+
+    Arena *arena() const noexcept
+    {
+        return _arena;
+    }
+
+    template <class U>
+    friend bool operator==(
+        const ArenaAllocator &a, const ArenaAllocator<U> &b) noexcept
+    {
+        return a.arena() == b.arena();
+    }
+
+private:
+    Arena *_arena;
+};
+
+// Parses into `arena`, as `parse` with an `ArenaAllocator`.
+template <std::input_iterator I, std::sentinel_for<I> S>
+inline ParseResult<I, arena::Document>
+parse(I first, S last, const ParseOptions &opts, Arena &arena)
+{
+    return parse(std::move(first), std::move(last), opts,
+                 ArenaAllocator<std::byte>(arena));
+}
+
+template <std::ranges::input_range R>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>, arena::Document>
+parse(R &&r, const ParseOptions &opts, Arena &arena)
+{
+    return parse(std::ranges::begin(r), std::ranges::end(r), opts, arena);
+}
+
+template <std::ranges::input_range R>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>, arena::Document>
+parse(R &&r, Arena &arena)
+{
+    return parse(std::forward<R>(r), ParseOptions(), arena);
+}
+
+} // namespace htl::json
+
+#endif
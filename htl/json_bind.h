@@ -0,0 +1,983 @@
+/**
+ * @file htl/json_bind.h
+ *
+ * Binding of JSON documents to C++ types
+ */
+
+#ifndef HTL_JSON_BIND_H_
+#define HTL_JSON_BIND_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <htl/json.h>
+#include <htl/rational.h>
+#include <htl/uuid.h>
+
+namespace htl::json {
+
+// Describes the JSON object members of a class. Specializations define a
+// static constexpr tuple of `field`s named `fields`:
+//
+//     template <>
+//     struct htl::json::Bind<Point> {
+//         static constexpr auto fields =
+//             std::tuple(field("x", &Point::x), field("y", &Point::y));
+//     };
+template <class T>
+struct Bind;
+
+template <class T, class M>
+struct Field {
+    std::string_view name;
+    M T::*member;
+};
+
+template <class T, class M>
+constexpr Field<T, M> field(std::string_view name, M T::*member) noexcept
+{
+    return { name, member };
+}
+
+namespace detail {
+
+template <class T>
+concept bound_class = requires { Bind<T>::fields; };
+
+template <class T>
+struct is_bound_string : std::false_type {};
+
+template <class Traits, class A>
+struct is_bound_string<std::basic_string<char, Traits, A>> : std::true_type {};
+
+template <class Alloc>
+struct is_bound_string<BasicString<Alloc>> : std::true_type {};
+
+// Containers read as arrays by appending elements, such as `std::vector`,
+// `std::deque` and `std::list`.
+template <class T>
+concept bound_sequence =
+    std::ranges::input_range<const T> && requires(T &value) {
+        value.clear();
+        value.emplace_back();
+    };
+
+template <class T>
+struct is_bound_optional : std::false_type {};
+
+template <class T>
+struct is_bound_optional<std::optional<T>> : std::true_type {};
+
+template <class T>
+struct is_bound_document : std::false_type {};
+
+template <class Alloc>
+struct is_bound_document<BasicDocument<Alloc>> : std::true_type {};
+
+template <class T>
+struct is_bound_rational : std::false_type {};
+
+template <class T>
+struct is_bound_rational<Rational<T>> : std::true_type {};
+
+template <class T>
+concept bound_map =
+    std::ranges::input_range<const T> &&
+    requires { typename std::ranges::range_value_t<T>::first_type; } &&
+    std::convertible_to<
+        const typename std::ranges::range_value_t<T>::first_type &,
+        std::string_view>;
+
+// Maps read as objects, such as `std::map` and `std::unordered_map`, or
+// sequences of key and value pairs.
+template <class T>
+concept bound_readable_map =
+    bound_map<T> &&
+    is_bound_string<std::remove_const_t<
+        typename std::ranges::range_value_t<T>::first_type>>::value &&
+    (bound_sequence<T> || requires(T &value, typename T::key_type key) {
+        value.clear();
+        value.try_emplace(std::move(key));
+    });
+
+template <class T>
+struct is_json_value : is_bound_document<T> {};
+
+template <class Alloc>
+struct is_json_value<BasicString<Alloc>> : std::true_type {};
+
+template <class Alloc>
+struct is_json_value<BasicArray<Alloc>> : std::true_type {};
+
+template <class Alloc>
+struct is_json_value<BasicObject<Alloc>> : std::true_type {};
+
+// Types written by the bound `serialize`, which leaves the types of json.h to
+// the overloads there.
+template <class T>
+concept bound_value =
+    !is_json_value<T>::value &&
+    (bound_class<T> || is_bound_optional<T>::value ||
+     is_bound_rational<T>::value || std::same_as<T, UUID> ||
+     std::ranges::input_range<const T>);
+
+constexpr std::uint32_t hash_field_name(
+    std::string_view name, std::uint32_t seed) noexcept
+{
+    std::uint32_t hash = 2166136261u ^ seed;
+
+    for (char c: name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
+// Perfect hash table from field names to their indices, found at compile
+// time. Should no seed separate the names, every name is compared instead.
+template <std::size_t N>
+struct FieldTable {
+    static constexpr std::size_t slot_count = std::bit_ceil(4 * N + 1);
+
+    std::array<std::string_view, N> names;
+    std::array<std::uint16_t, slot_count> slots;
+    std::uint32_t seed;
+    bool is_perfect;
+
+    consteval explicit FieldTable(std::array<std::string_view, N> names)
+        : names(names), slots(), seed(), is_perfect()
+    {
+        static_assert(N < std::numeric_limits<std::uint16_t>::max());
+
+        for (std::size_t i = 0; i < N; ++i) {
+            for (std::size_t j = 0; j < i; ++j) {
+                if (names[i] == names[j]) {
+                    throw "duplicate field name";
+                }
+            }
+        }
+
+        for (seed = 0; seed < 1024 && !is_perfect; ++seed) {
+            slots.fill(N);
+            is_perfect = true;
+
+            for (std::size_t i = 0; i < N && is_perfect; ++i) {
+                auto &slot =
+                    slots[hash_field_name(names[i], seed) & (slot_count - 1)];
+
+                is_perfect = slot == N;
+                slot = i;
+            }
+        }
+
+        --seed;
+    }
+
+    // Index of the field named `name`, or `N` if there is none.
+    constexpr std::size_t find(std::string_view name) const noexcept
+    {
+        if (is_perfect) {
+            std::size_t i =
+                slots[hash_field_name(name, seed) & (slot_count - 1)];
+
+            return i < N && names[i] == name ? i : N;
+        }
+
+        for (std::size_t i = 0; i < N; ++i) {
+            if (names[i] == name) {
+                return i;
+            }
+        }
+
+        return N;
+    }
+};
+
+template <class T>
+struct BoundFields {
+    using Fields = std::remove_cvref_t<decltype(Bind<T>::fields)>;
+
+    static constexpr std::size_t size = std::tuple_size_v<Fields>;
+
+    static constexpr FieldTable<size> table =
+        FieldTable<size>(std::apply(
+            [](auto &...fields) {
+                return std::array<std::string_view, size>{ fields.name... };
+            },
+            Bind<T>::fields));
+};
+
+// String destination of fixed capacity, for the text of values such as UUIDs.
+// Longer strings are marked as truncated.
+template <std::size_t N>
+struct FixedString {
+    using value_type = char;
+
+    std::array<char, N> chars;
+    std::size_t size = 0;
+    bool is_truncated = false;
+
+    void append(const char *s, std::size_t n) noexcept
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            push_back(s[i]);
+        }
+    }
+
+    void push_back(char c) noexcept
+    {
+        if (size < N) {
+            chars[size++] = c;
+        } else {
+            is_truncated = true;
+        }
+    }
+
+    std::string_view view() const noexcept
+    {
+        return { chars.data(), size };
+    }
+};
+
+// Parses input straight into values of bound types, using `ParseHandler` to
+// read the tokens. Members without a field are validated and skipped.
+template <class I, class S, class Alloc>
+struct BindParseHandler {
+    using Reader = ParseHandler<I, S, Alloc>;
+
+    // Open containers of a skipped value: brackets for those yet to hold an
+    // element, and `a` or `o` after the first.
+    using SkipStack = typename Reader::KeyBuffer;
+
+    Reader reader;
+    BasicDocument<Alloc> number;
+    std::size_t depth;
+
+    BindParseHandler(I first, S last, const Alloc &alloc,
+                     const ParseOptions &opts)
+        : reader(std::move(first), std::move(last), alloc, alloc, opts),
+          number(alloc), depth(0)
+    {
+        // Numbers are converted as soon as they are read, and keeping their
+        // text would only skip the range check.
+        reader.opts.lazy_numbers = false;
+    }
+
+    template <class T>
+    ParseResult<I, T> parse()
+    {
+        T value{};
+
+        read(value);
+
+        reader.locate_position();
+        return {
+            std::move(reader.first),
+            std::move(value),
+            { reader.code, reader.line, reader.column, reader.offset },
+        };
+    }
+
+    template <class T>
+    void read(T &dest)
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        if constexpr (std::same_as<T, bool>) {
+            read_bool(dest);
+        } else if constexpr (std::integral<T> || std::floating_point<T>) {
+            read_number(dest);
+        } else if constexpr (is_bound_string<T>::value) {
+            read_string(dest);
+        } else if constexpr (is_bound_optional<T>::value) {
+            read_optional(dest);
+        } else if constexpr (std::same_as<T, UUID>) {
+            read_uuid(dest);
+        } else if constexpr (is_bound_rational<T>::value) {
+            read_rational(dest);
+        } else if constexpr (is_bound_document<T>::value) {
+            read_document(dest);
+        } else if constexpr (is_json_value<T>::value) {
+            read_json_value(dest);
+        } else if constexpr (bound_class<T>) {
+            read_object(dest);
+        } else if constexpr (bound_readable_map<T>) {
+            read_map(dest);
+        } else {
+            static_assert(bound_sequence<T>, "type is not bound to JSON");
+            read_sequence(dest);
+        }
+    }
+
+    void read_bool(bool &dest)
+    {
+        switch (reader.peek()) {
+        case 't':
+            reader.expect_next("true");
+            dest = true;
+            break;
+        case 'f':
+            reader.expect_next("false");
+            dest = false;
+            break;
+        default:
+            reader.set_type_mismatch();
+            break;
+        }
+    }
+
+    template <class T>
+    void read_number(T &dest)
+    {
+        if (reader.peek() != '-' && !ascii_isdigit(reader.peek())) {
+            reader.set_type_mismatch();
+            return;
+        }
+
+        reader.read_number(number);
+
+        if (reader.has_error()) {
+            return;
+        } else if constexpr (std::floating_point<T>) {
+            dest = number.is_int() ? static_cast<T>(number.get_int())
+                                   : static_cast<T>(number.get_float());
+        } else if (!number.is_int()) {
+            reader.set_type_mismatch();
+        } else if (!std::in_range<T>(number.get_int())) {
+            reader.set_number_out_of_range();
+        } else {
+            dest = static_cast<T>(number.get_int());
+        }
+    }
+
+    template <class T>
+    void read_string(T &dest)
+    {
+        if (reader.peek() != '"') {
+            reader.set_type_mismatch();
+            return;
+        }
+
+        dest.clear();
+        reader.read_string(dest);
+    }
+
+    template <class T>
+    void read_optional(std::optional<T> &dest)
+    {
+        if (reader.peek() == 'n') {
+            reader.expect_next("null");
+            dest.reset();
+        } else {
+            read(dest.emplace());
+        }
+    }
+
+    // A string of the form written by `to_chars`, or in braces.
+    void read_uuid(UUID &dest)
+    {
+        FixedString<38> text;
+        std::error_code err;
+
+        if (!read_fixed_string(text)) {
+            return;
+        }
+
+        UUID value = make_uuid(text.view(), err);
+
+        if (text.is_truncated || err) {
+            reader.set_type_mismatch();
+        } else {
+            dest = value;
+        }
+    }
+
+    // A string of the form `numer/denom`.
+    template <class T>
+    void read_rational(Rational<T> &dest)
+    {
+        FixedString<2 * std::numeric_limits<T>::digits10 + 8> text;
+        T numer{};
+        T denom{};
+
+        if (!read_fixed_string(text)) {
+            return;
+        }
+
+        const char *first = text.chars.data();
+        const char *last = first + text.size;
+        auto slash = std::from_chars(first, last, numer);
+
+        if (text.is_truncated || slash.ec == std::errc::invalid_argument ||
+            slash.ptr == last || *slash.ptr != '/') {
+            reader.set_type_mismatch();
+            return;
+        }
+
+        auto end = std::from_chars(slash.ptr + 1, last, denom);
+
+        if (end.ec == std::errc::invalid_argument || end.ptr != last) {
+            reader.set_type_mismatch();
+        } else if (slash.ec != std::errc() || end.ec != std::errc()) {
+            reader.set_number_out_of_range();
+        } else {
+            dest.assign(numer, denom);
+        }
+    }
+
+    template <std::size_t N>
+    bool read_fixed_string(FixedString<N> &dest)
+    {
+        if (reader.peek() != '"') {
+            reader.set_type_mismatch();
+            return false;
+        }
+
+        reader.read_string(dest);
+        return !reader.has_error();
+    }
+
+    template <class T>
+    void read_sequence(T &dest)
+    {
+        if (!start_container('[')) {
+            return;
+        }
+
+        dest.clear();
+        for (bool empty = true;
+             !reader.has_error() && reader.next_element(']', empty);
+             empty = false) {
+            if constexpr (std::same_as<std::ranges::range_value_t<T>, bool>) {
+                bool value = false;
+
+                read(value);
+                dest.push_back(value);
+            } else {
+                read(dest.emplace_back());
+            }
+        }
+
+        --depth;
+    }
+
+    // When duplicate keys are accepted, a map keeps the last value of a key,
+    // and a sequence of pairs keeps every member.
+    template <class T>
+    void read_map(T &dest)
+    {
+        using Key = std::remove_const_t<
+            typename std::ranges::range_value_t<T>::first_type>;
+
+        if (!start_container('{')) {
+            return;
+        }
+
+        dest.clear();
+        for (bool empty = true;
+             !reader.has_error() && reader.next_element('}', empty);
+             empty = false) {
+            Key key{};
+
+            if (!read_key(key)) {
+                return;
+            }
+
+            if constexpr (bound_sequence<T>) {
+                auto it = reader.opts.accept_duplicate_keys
+                              ? dest.end()
+                              : std::ranges::find(dest, key, [](auto &entry) {
+                                    return std::string_view(entry.first);
+                                });
+
+                if (it != dest.end()) {
+                    reader.set_duplicate_key();
+                } else {
+                    auto &entry = dest.emplace_back();
+
+                    entry.first = std::move(key);
+                    read(entry.second);
+                }
+            } else {
+                auto [it, is_inserted] = dest.try_emplace(std::move(key));
+
+                if (!is_inserted && !reader.opts.accept_duplicate_keys) {
+                    reader.set_duplicate_key();
+                } else {
+                    read(it->second);
+                }
+            }
+        }
+
+        --depth;
+    }
+
+    // Reads a member name and its colon.
+    template <class K>
+    bool read_key(K &dest)
+    {
+        if (reader.peek() != '"') {
+            reader.set_unexpected_token();
+            return false;
+        }
+
+        reader.read_string(dest);
+        if (reader.has_error() || reader.consume_whitespace_and_comments()) {
+            return false;
+        } else if (reader.next() != ':') {
+            reader.set_unexpected_token();
+            return false;
+        }
+
+        return true;
+    }
+
+    template <class T>
+    void read_object(T &dest)
+    {
+        using Fields = BoundFields<T>;
+
+        std::bitset<Fields::size> seen;
+
+        if (!start_container('{')) {
+            return;
+        }
+
+        for (bool empty = true;
+             !reader.has_error() && reader.next_element('}', empty);
+             empty = false) {
+            reader.key_buffer.clear();
+            if (!read_key(reader.key_buffer)) {
+                return;
+            }
+
+            std::size_t i = Fields::table.find(reader.key_buffer);
+
+            if (i == Fields::size) {
+                skip_value();
+            } else if (seen[i] && !reader.opts.accept_duplicate_keys) {
+                reader.set_duplicate_key();
+            } else {
+                seen[i] = true;
+                read_field(dest, i, std::make_index_sequence<Fields::size>());
+            }
+        }
+
+        --depth;
+    }
+
+    template <class T, std::size_t... Is>
+    void read_field(T &dest, std::size_t i, std::index_sequence<Is...>)
+    {
+        ((i == Is && (read(dest.*std::get<Is>(Bind<T>::fields).member),
+                      true)) ||
+         ...);
+    }
+
+    void read_document(BasicDocument<Alloc> &dest)
+    {
+        std::size_t base = reader.stack.size();
+
+        reader.start_document(dest);
+        while (!reader.has_error() && reader.stack.size() > base) {
+            if (depth + reader.stack.size() - base > reader.opts.max_depth) {
+                reader.set_max_depth();
+                break;
+            }
+
+            reader.continue_document(*reader.stack.back());
+        }
+    }
+
+    // Reads a string, array or object of the allocator of the parse.
+    template <class T>
+    void read_json_value(T &dest)
+    {
+        static_assert(std::same_as<typename T::allocator_type, Alloc>,
+                      "allocator differs from that of the parse");
+
+        constexpr char open = std::same_as<T, BasicArray<Alloc>> ? '[' : '{';
+        BasicDocument<Alloc> value(reader.alloc);
+
+        if (reader.peek() != open) {
+            reader.set_type_mismatch();
+            return;
+        }
+
+        read_document(value);
+        if (!reader.has_error()) {
+            if constexpr (open == '[') {
+                dest = std::move(value.get_array());
+            } else {
+                dest = std::move(value.get_object());
+            }
+        }
+    }
+
+    // Consumes the opening bracket of a container.
+    bool start_container(char open)
+    {
+        if (reader.peek() != open) {
+            reader.set_type_mismatch();
+            return false;
+        }
+
+        reader.skip();
+        if (++depth > reader.opts.max_depth) {
+            reader.set_max_depth();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Validates and discards a value. Duplicate keys within it are not
+    // detected.
+    void skip_value()
+    {
+        SkipStack stack(reader.key_buffer.get_allocator());
+
+        skip_element(stack);
+        while (!reader.has_error() && stack.size()) {
+            char &top = stack.back();
+            bool is_object = top == '{' || top == 'o';
+            bool empty = top == '{' || top == '[';
+
+            if (!reader.next_element(is_object ? '}' : ']', empty)) {
+                stack.pop_back();
+                continue;
+            }
+
+            top = is_object ? 'o' : 'a';
+            if (is_object) {
+                if (reader.peek() != '"') {
+                    reader.set_unexpected_token();
+                    return;
+                }
+
+                NullString key;
+
+                reader.read_string(key);
+                if (reader.has_error() ||
+                    reader.consume_whitespace_and_comments()) {
+                    return;
+                } else if (reader.next() != ':') {
+                    reader.set_unexpected_token();
+                    return;
+                }
+            }
+
+            skip_element(stack);
+        }
+    }
+
+    void skip_element(SkipStack &stack)
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case '{':
+        case '[':
+            stack.push_back(reader.next());
+            if (depth + stack.size() > reader.opts.max_depth) {
+                reader.set_max_depth();
+            }
+            break;
+        case '"': {
+            NullString value;
+
+            reader.read_string(value);
+            break;
+        }
+        case 't':
+            reader.expect_next("true");
+            break;
+        case 'f':
+            reader.expect_next("false");
+            break;
+        case 'n':
+            reader.expect_next("null");
+            break;
+        default:
+            reader.read_number(number);
+            break;
+        }
+    }
+};
+
+constexpr std::size_t escaped_field_name_size(std::string_view name) noexcept
+{
+    std::size_t size = 0;
+
+    for (char c: name) {
+        if (c == '"' || c == '\\') {
+            size += 2;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            size += 6;
+        } else {
+            size += 1;
+        }
+    }
+
+    return size;
+}
+
+constexpr char *escape_field_name(std::string_view name, char *out) noexcept
+{
+    for (char c: name) {
+        auto uc = static_cast<unsigned char>(c);
+
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = c;
+        } else if (uc < 0x20) {
+            for (char d: { '\\', 'u', '0', '0' }) {
+                *out++ = d;
+            }
+
+            *out++ = htl::detail::hex_charset_lower[uc >> 4];
+            *out++ = htl::detail::hex_charset_lower[uc & 15];
+        } else {
+            *out++ = c;
+        }
+    }
+
+    return out;
+}
+
+// The text before each member of a bound class: the opening brace or a comma,
+// and the escaped, quoted name with its colon, as in `,"name":`. Built at
+// compile time, so that each is written with a single copy.
+template <class T>
+struct FieldPrefixes {
+    static constexpr std::size_t size = BoundFields<T>::size;
+
+    static constexpr std::size_t length = [] {
+        std::size_t length = 0;
+
+        for (auto name: BoundFields<T>::table.names) {
+            length += escaped_field_name_size(name) + 4;
+        }
+
+        return length;
+    }();
+
+    static constexpr std::array<std::size_t, size + 1> offsets = [] {
+        std::array<std::size_t, size + 1> offsets{};
+
+        for (std::size_t i = 0; i < size; ++i) {
+            offsets[i + 1] =
+                offsets[i] +
+                escaped_field_name_size(BoundFields<T>::table.names[i]) + 4;
+        }
+
+        return offsets;
+    }();
+
+    static constexpr std::array<char, length> chars = [] {
+        std::array<char, length> chars{};
+        char *out = chars.data();
+
+        for (std::size_t i = 0; i < size; ++i) {
+            *out++ = i ? ',' : '{';
+            *out++ = '"';
+            out = escape_field_name(BoundFields<T>::table.names[i], out);
+            *out++ = '"';
+            *out++ = ':';
+        }
+
+        return chars;
+    }();
+
+    static constexpr std::string_view get(std::size_t i) noexcept
+    {
+        return { chars.data() + offsets[i], offsets[i + 1] - offsets[i] };
+    }
+};
+
+// Writes values of bound types, using `SerializeHandler` for strings and
+// numbers and for any documents within them.
+template <class O>
+struct BindSerializeHandler {
+    using Writer = SerializeHandler<O, std::allocator<std::byte>>;
+
+    Writer writer;
+
+    BindSerializeHandler(O out, const SerializeOptions &opts)
+        : writer(std::move(out), std::allocator<std::byte>(), opts)
+    {}
+
+    template <class T>
+    void write(const T &value)
+    {
+        if constexpr (std::same_as<T, Null> || std::same_as<T, Bool> ||
+                      std::integral<T> || std::floating_point<T>) {
+            writer.serialize(value);
+        } else if constexpr (std::convertible_to<const T &,
+                                                 std::string_view>) {
+            writer.serialize_string(value);
+        } else if constexpr (is_bound_optional<T>::value) {
+            if (value) {
+                write(*value);
+            } else {
+                writer.serialize(nullptr);
+            }
+        } else if constexpr (std::same_as<T, UUID>) {
+            writer.write('"');
+            to_chars(value, writer.out.inserter());
+            writer.write('"');
+        } else if constexpr (is_bound_rational<T>::value) {
+            writer.write('"');
+            writer.serialize(value.numer());
+            writer.write('/');
+            writer.serialize(value.denom());
+            writer.write('"');
+        } else if constexpr (is_json_value<T>::value) {
+            writer.serialize_nested(value);
+        } else if constexpr (bound_class<T>) {
+            write_object(value,
+                         std::make_index_sequence<BoundFields<T>::size>());
+        } else if constexpr (bound_map<T>) {
+            write_container('{', '}', value, [&](const auto &entry) {
+                writer.serialize_string(entry.first);
+                writer.write(':');
+                write(entry.second);
+            });
+        } else {
+            static_assert(std::ranges::input_range<const T>,
+                          "type is not bound to JSON");
+            write_container('[', ']', value,
+                            [&](const auto &element) { write(element); });
+        }
+    }
+
+    template <class T, std::size_t... Is>
+    void write_object(const T &value, std::index_sequence<Is...>)
+    {
+        if constexpr (sizeof...(Is) == 0) {
+            writer.write("{}");
+        } else {
+            (write_field<T, Is>(value), ...);
+            writer.end_container('}');
+        }
+    }
+
+    template <class T, std::size_t I>
+    void write_field(const T &value)
+    {
+        constexpr std::string_view prefix = FieldPrefixes<T>::get(I);
+
+        if (writer.opts.indent_size) {
+            writer.next_element(prefix[0], I == 0);
+            writer.write(prefix.substr(1));
+        } else {
+            writer.write(prefix);
+        }
+
+        write(value.*std::get<I>(Bind<T>::fields).member);
+    }
+
+    void write_container(char open, char close, const auto &value,
+                         auto &&write_element)
+    {
+        bool empty = true;
+
+        for (auto &&element: value) {
+            writer.next_element(empty ? open : ',', empty);
+            write_element(element);
+            empty = false;
+        }
+
+        if (empty) {
+            writer.write(open);
+            writer.write(close);
+        } else {
+            writer.end_container(close);
+        }
+    }
+};
+
+} // namespace detail
+
+// Parses a value of type `T` without building a document. `T` may be `bool`,
+// an arithmetic type, `std::string`, `std::optional` of a supported type,
+// `UUID` or `Rational` from a string, a container with `emplace_back` such as
+// `std::vector` of a supported type, a map with string keys, `BasicDocument`
+// and the other types of json.h, or a class with a `Bind` specialization.
+// Object members without a field are skipped, and fields without a member
+// are left value initialized. Values of the wrong type fail the parse with
+// `ParseErrorCode::TypeMismatch`.
+template <class T, std::input_iterator I, std::sentinel_for<I> S,
+          class Alloc = std::allocator<std::byte>>
+inline ParseResult<I, T> parse_into(
+    I first, S last, const ParseOptions &opts = ParseOptions(),
+    const Alloc &alloc = Alloc())
+{
+    if constexpr (detail::contiguous_input<I, S>) {
+        const char *data = detail::to_char_pointer(first);
+        detail::BindParseHandler<const char *, const char *, Alloc> handler(
+            data, data + (last - first), alloc, opts);
+        auto result = handler.template parse<T>();
+
+        return {
+            std::move(first) + (result.in - data),
+            std::move(result.value),
+            result.error,
+        };
+    } else {
+        detail::BindParseHandler<I, S, Alloc> handler(
+            std::move(first), std::move(last), alloc, opts);
+
+        return handler.template parse<T>();
+    }
+}
+
+template <class T, std::ranges::input_range R,
+          class Alloc = std::allocator<std::byte>>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>, T>
+parse_into(R &&r, const ParseOptions &opts = ParseOptions(),
+           const Alloc &alloc = Alloc())
+{
+    return parse_into<T>(std::ranges::begin(r), std::ranges::end(r), opts,
+                         alloc);
+}
+
+// Serializes a value of a bound type without building a document, in the form
+// read by `parse_into`. Ranges of pairs with string keys are written as
+// objects, other ranges as arrays, and `UUID` and `Rational` values as
+// strings. Empty optionals are written as null. Ranges which cannot be
+// appended to, such as `std::array` and `std::set`, are only written.
+template <class T, std::output_iterator<char> O>
+    requires detail::bound_value<T>
+inline O serialize(const T &value, O out,
+                   const SerializeOptions &opts = SerializeOptions())
+{
+    detail::BindSerializeHandler<O> handler(std::move(out), opts);
+
+    handler.write(value);
+    return handler.writer.out.release();
+}
+
+} // namespace htl::json
+
+#endif
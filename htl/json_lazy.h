@@ -0,0 +1,919 @@
+/**
+ * @file htl/json_lazy.h
+ *
+ * On demand access to JSON text
+ */
+
+#ifndef HTL_JSON_LAZY_H_
+#define HTL_JSON_LAZY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <htl/json.h>
+
+namespace htl::json {
+
+namespace detail {
+
+// Index of a validated document, shared by the values which refer to it.
+template <class Alloc>
+struct LazyTape {
+    using Index =
+        std::vector<std::size_t, typename std::allocator_traits<
+                                     Alloc>::rebind_alloc<std::size_t>>;
+
+    using Reader = ParseHandler<const char *, const char *, Alloc>;
+
+    const char *first;
+    const char *last;
+
+    // Offsets of the structural characters of the document.
+    Index offsets;
+
+    // For each opening bracket, the position in `offsets` of its closing
+    // bracket, and for each closing bracket, the size of its container.
+    Index links;
+
+    ParseOptions opts;
+    [[no_unique_address]] Alloc alloc;
+
+    LazyTape(const char *first, const char *last, const ParseOptions &opts,
+             const Alloc &alloc)
+        : first(first), last(last), offsets(alloc), links(alloc), opts(opts),
+          alloc(alloc)
+    {}
+
+    const char *token(std::size_t pos) const noexcept
+    {
+        return first + offsets[pos];
+    }
+
+    // Position of the token following the value at `pos`.
+    std::size_t skip(std::size_t pos) const noexcept
+    {
+        char c = *token(pos);
+        return c == '[' || c == '{' ? links[pos] + 1 : pos + 1;
+    }
+
+    // Position of the element after the one at `pos`, or of the closing
+    // bracket. Object members are skipped as a key, colon, and value.
+    std::size_t next_element(std::size_t pos, bool is_object) const noexcept
+    {
+        pos = skip(is_object ? pos + 2 : pos);
+        return *token(pos) == ',' ? pos + 1 : pos;
+    }
+
+    Reader reader(std::size_t pos) const
+    {
+        return Reader(token(pos), last, alloc, alloc, opts);
+    }
+
+    // Whether the string at `pos` decodes to `key`. Strings without escapes
+    // or characters to re-encode are compared in place.
+    bool key_equals(std::size_t pos, std::string_view key) const
+    {
+        Reader reader(token(pos) + 1, last, alloc, alloc, opts);
+        const char *run = reader.find_string_run();
+
+        if (*run == '"') {
+            return std::string_view(reader.first, run) == key;
+        }
+
+        BasicString<Alloc> value(alloc);
+
+        reader.first = token(pos);
+        reader.read_string(value);
+        return value == key;
+    }
+};
+
+// Builds and validates the index of a `BasicLazyDocument`. Scalars are only
+// checked, never stored, and containers are only matched. Input this handler
+// rejects is parsed again by `ParseHandler`, so that errors are reported
+// identically.
+template <class Alloc>
+struct LazyParseHandler {
+    struct Frame {
+        std::size_t open;
+        std::size_t size;
+        std::size_t key_count;
+        std::size_t decoded_size;
+        bool is_object;
+    };
+
+    struct Key {
+        std::size_t offset;
+        std::size_t size;
+        bool is_decoded;
+    };
+
+    template <class T>
+    using Vector =
+        std::vector<T, typename std::allocator_traits<Alloc>::rebind_alloc<T>>;
+
+    using Tape = LazyTape<Alloc>;
+    using Reader = typename Tape::Reader;
+    using Buffer = std::basic_string<
+        char, std::char_traits<char>,
+        typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+
+    Tape &tape;
+    std::size_t pos;
+    const char *end;
+    Reader reader;
+    Vector<Frame> stack;
+    Vector<Key> keys;
+    Vector<std::string_view> views;
+    Buffer decoded;
+
+    LazyParseHandler(Tape &tape)
+        : tape(tape), pos(0), end(tape.first),
+          reader(tape.first, tape.last, tape.alloc, tape.alloc, tape.opts),
+          stack(tape.alloc), keys(tape.alloc), views(tape.alloc),
+          decoded(tape.alloc)
+    {}
+
+    static ParseResult<const char *, BasicLazyDocument<Alloc>>
+    parse(const char *first, const char *last, const ParseOptions &opts,
+          const Alloc &alloc)
+    {
+        if (opts.accept_comments) {
+            return { first, BasicLazyDocument<Alloc>(alloc),
+                     ParseError(ParseErrorCode::UnsupportedOption, 0, 0, 0) };
+        }
+
+        auto tape = std::allocate_shared<Tape>(alloc, first, last, opts, alloc);
+        LazyParseHandler handler(*tape);
+
+        if (handler.parse()) {
+            auto [line, column] = locate(first, handler.end);
+
+            return {
+                handler.end,
+                BasicLazyDocument<Alloc>(std::move(tape)),
+                { ParseErrorCode(), line, column, handler.end - first },
+            };
+        }
+
+        auto result = ParseHandler<const char *, const char *, Alloc>(
+                          first, last, alloc, alloc, opts)
+                          .parse();
+
+        if (!result.error) {
+            auto [line, column] = locate(first, handler.reader.first);
+
+            result.error = ParseError(ParseErrorCode::UnexpectedToken, line,
+                                      column, handler.reader.first - first);
+        }
+
+        return { result.in, BasicLazyDocument<Alloc>(alloc), result.error };
+    }
+
+    bool parse()
+    {
+        build_structural_index(tape.first, tape.last, tape.offsets);
+        tape.links.resize(tape.offsets.size());
+
+        if (!start_value()) {
+            return false;
+        }
+
+        while (stack.size()) {
+            if (stack.size() > tape.opts.max_depth ||
+                !(stack.back().is_object ? continue_object()
+                                         : continue_array())) {
+                return false;
+            }
+        }
+
+        tape.offsets.resize(pos);
+        tape.links.resize(pos);
+        return true;
+    }
+
+    bool done()
+    {
+        return pos == tape.offsets.size();
+    }
+
+    const char *token()
+    {
+        return tape.token(pos);
+    }
+
+    // Checks that only whitespace is between `p` and the next token.
+    bool expect_token(const char *p)
+    {
+        const char *next = done() ? tape.last : token();
+        return p <= next && std::all_of(p, next, is_json_whitespace);
+    }
+
+    bool start_value()
+    {
+        if (done()) {
+            return false;
+        }
+
+        const char *p = token();
+        NullString null_string;
+
+        switch (*p) {
+        case '[':
+        case '{':
+            stack.push_back(
+                { pos++, 0, keys.size(), decoded.size(), *p == '{' });
+            end = p + 1;
+            return true;
+        case '"':
+            ++pos;
+            reader.first = p;
+            reader.read_string(null_string);
+            return end_scalar();
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            ++pos;
+            reader.first = p;
+            return read_number() && end_scalar();
+        case 't':
+            return read_literal(p, "true");
+        case 'f':
+            return read_literal(p, "false");
+        case 'n':
+            return read_literal(p, "null");
+        default:
+            return false;
+        }
+    }
+
+    // Numbers are only converted when they may be out of range.
+    bool read_number()
+    {
+        const char *start = reader.first;
+        bool is_int = true;
+
+        if (!reader.scan_number(is_int, [](char) {})) {
+            return false;
+        }
+
+        reader.check_number(start, reader.first, is_int);
+        return !reader.has_error();
+    }
+
+    bool read_literal(const char *p, std::string_view literal)
+    {
+        if (static_cast<std::size_t>(tape.last - p) < literal.size() ||
+            literal.compare(0, literal.size(), p, literal.size())) {
+            reader.first = p;
+            return false;
+        }
+
+        ++pos;
+        reader.first = p + literal.size();
+        return end_scalar();
+    }
+
+    bool end_scalar()
+    {
+        if (reader.has_error() ||
+            (stack.size() && !expect_token(reader.first))) {
+            return false;
+        }
+
+        end = reader.first;
+        return true;
+    }
+
+    bool start_element()
+    {
+        ++stack.back().size;
+        return start_value();
+    }
+
+    bool continue_array()
+    {
+        if (done()) {
+            return false;
+        }
+
+        switch (*token()) {
+        case ']':
+            return close();
+        case ',':
+            ++pos;
+            if (!stack.back().size || done()) {
+                return false;
+            } else if (*token() == ']') {
+                return tape.opts.accept_trailing_commas && close();
+            }
+
+            return start_element();
+        default:
+            return !stack.back().size && start_element();
+        }
+    }
+
+    bool continue_object()
+    {
+        if (done()) {
+            return false;
+        }
+
+        switch (*token()) {
+        case '}':
+            return close();
+        case ',':
+            ++pos;
+            if (!stack.back().size || done()) {
+                return false;
+            } else if (*token() == '}') {
+                return tape.opts.accept_trailing_commas && close();
+            }
+
+            return start_entry();
+        case '"':
+            return !stack.back().size && start_entry();
+        default:
+            return false;
+        }
+    }
+
+    bool start_entry()
+    {
+        if (done() || *token() != '"') {
+            return false;
+        }
+
+        const char *p = token();
+        ++pos;
+
+        if (tape.opts.accept_duplicate_keys) {
+            NullString null_string;
+
+            reader.first = p;
+            reader.read_string(null_string);
+        } else if (!read_key(p)) {
+            return false;
+        }
+
+        if (reader.has_error() || !expect_token(reader.first) || done() ||
+            *token() != ':') {
+            return false;
+        }
+
+        ++pos;
+        ++stack.back().size;
+        return start_value();
+    }
+
+    // Keeps the key at `p` for `check_keys`, in place unless it must be
+    // decoded.
+    bool read_key(const char *p)
+    {
+        reader.first = p + 1;
+
+        const char *run = reader.find_string_run();
+
+        if (run != tape.last && *run == '"') {
+            keys.push_back(
+                { static_cast<std::size_t>(p + 1 - tape.first),
+                  static_cast<std::size_t>(run - p - 1), false });
+            reader.first = run + 1;
+            return true;
+        }
+
+        std::size_t offset = decoded.size();
+
+        reader.first = p;
+        reader.read_string(decoded);
+        keys.push_back({ offset, decoded.size() - offset, true });
+        return !reader.has_error();
+    }
+
+    bool close()
+    {
+        auto &frame = stack.back();
+        std::size_t at = pos++;
+
+        tape.links[frame.open] = at;
+        tape.links[at] = frame.size;
+        end = tape.token(at) + 1;
+
+        if (frame.is_object && !check_keys(frame)) {
+            return false;
+        }
+
+        keys.resize(frame.key_count);
+        decoded.resize(frame.decoded_size);
+        stack.pop_back();
+        return true;
+    }
+
+    bool check_keys(const Frame &frame)
+    {
+        if (tape.opts.accept_duplicate_keys ||
+            keys.size() - frame.key_count < 2) {
+            return true;
+        }
+
+        views.clear();
+        for (std::size_t i = frame.key_count; i < keys.size(); ++i) {
+            const char *data =
+                keys[i].is_decoded ? decoded.data() : tape.first;
+
+            views.emplace_back(data + keys[i].offset, keys[i].size);
+        }
+
+        std::sort(views.begin(), views.end());
+        return std::adjacent_find(views.begin(), views.end()) == views.end();
+    }
+};
+
+} // namespace detail
+
+// View of a value within a `BasicLazyDocument`, which decodes the value only
+// when it is accessed. Values refer to the document's index and input, and
+// are valid as long as both are.
+template <class Alloc>
+class BasicLazyValue {
+public:
+    BasicLazyValue() noexcept : _tape(), _pos() {}
+
+    Type type() const noexcept
+    {
+        if (!_tape) {
+            return Type::Null;
+        }
+
+        switch (*_token()) {
+        case '{':
+            return Type::Object;
+        case '[':
+            return Type::Array;
+        case '"':
+            return Type::String;
+        case 't':
+        case 'f':
+            return Type::Bool;
+        case 'n':
+            return Type::Null;
+        default:
+            auto end = std::find_if_not(_token(), _tape->last, [](char c) {
+                return ascii_isdigit(c) || c == '-';
+            });
+
+            return end != _tape->last &&
+                           (*end == '.' || *end == 'e' || *end == 'E')
+                       ? Type::Float
+                       : Type::Int;
+        }
+    }
+
+    bool is_null() const noexcept
+    {
+        return type() == Type::Null;
+    }
+
+    bool is_bool() const noexcept
+    {
+        return type() == Type::Bool;
+    }
+
+    bool is_int() const noexcept
+    {
+        return type() == Type::Int;
+    }
+
+    bool is_float() const noexcept
+    {
+        return type() == Type::Float;
+    }
+
+    bool is_string() const noexcept
+    {
+        return type() == Type::String;
+    }
+
+    bool is_array() const noexcept
+    {
+        return type() == Type::Array;
+    }
+
+    bool is_object() const noexcept
+    {
+        return type() == Type::Object;
+    }
+
+    Bool get_bool() const noexcept
+    {
+        return *_token() == 't';
+    }
+
+    Int get_int() const
+    {
+        return _read_number().get_int();
+    }
+
+    Float get_float() const
+    {
+        return _read_number().get_float();
+    }
+
+    BasicString<Alloc> get_string() const
+    {
+        BasicString<Alloc> value(_tape->alloc);
+
+        _tape->reader(_pos).read_string(value);
+        return value;
+    }
+
+    BasicLazyArray<Alloc> get_array() const noexcept
+    {
+        return BasicLazyArray<Alloc>(_tape, _pos);
+    }
+
+    BasicLazyObject<Alloc> get_object() const noexcept
+    {
+        return BasicLazyObject<Alloc>(_tape, _pos);
+    }
+
+    // Decodes the whole value.
+    BasicDocument<Alloc> to_document() const
+    {
+        return _tape->reader(_pos).parse().value;
+    }
+
+    // Text of the value within the input.
+    std::string_view text() const
+    {
+        const char *first = _token();
+
+        switch (*first) {
+        case '{':
+        case '[':
+            return { first, _tape->token(_tape->links[_pos]) + 1 };
+        case 't':
+        case 'n':
+            return { first, 4 };
+        case 'f':
+            return { first, 5 };
+        case '"': {
+            auto reader = _tape->reader(_pos);
+            detail::NullString null_string;
+
+            reader.read_string(null_string);
+            return { first, reader.first };
+        }
+        default: {
+            auto reader = _tape->reader(_pos);
+            bool is_int = true;
+
+            reader.scan_number(is_int, [](char) {});
+            return { first, reader.first };
+        }
+        }
+    }
+
+private:
+    template <class>
+    friend class BasicLazyArray;
+
+    template <class>
+    friend class BasicLazyObject;
+
+    template <class>
+    friend class BasicLazyDocument;
+
+    const detail::LazyTape<Alloc> *_tape;
+    std::size_t _pos;
+
+    BasicLazyValue(const detail::LazyTape<Alloc> *tape,
+                   std::size_t pos) noexcept
+        : _tape(tape), _pos(pos)
+    {}
+
+    const char *_token() const noexcept
+    {
+        return _tape->token(_pos);
+    }
+
+    BasicDocument<Alloc> _read_number() const
+    {
+        BasicDocument<Alloc> value(_tape->alloc);
+
+        _tape->reader(_pos).read_number(value);
+        return value;
+    }
+};
+
+// View of the elements of a lazy array. Elements are found by skipping those
+// before them, so indexing is linear in the index.
+template <class Alloc>
+class BasicLazyArray {
+public:
+    using value_type = BasicLazyValue<Alloc>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = BasicLazyValue<Alloc>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept : _tape(), _pos() {}
+
+        value_type operator*() const noexcept
+        {
+            return value_type(_tape, _pos);
+        }
+
+        iterator &operator++() noexcept
+        {
+            _pos = _tape->next_element(_pos, false);
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const iterator &a, const iterator &b) noexcept
+        {
+            return a._pos == b._pos;
+        }
+
+    private:
+        friend class BasicLazyArray;
+
+        const detail::LazyTape<Alloc> *_tape;
+        std::size_t _pos;
+
+        iterator(const detail::LazyTape<Alloc> *tape, std::size_t pos) noexcept
+            : _tape(tape), _pos(pos)
+        {}
+    };
+
+    using const_iterator = iterator;
+
+    iterator begin() const noexcept
+    {
+        return iterator(_tape, _pos + 1);
+    }
+
+    iterator end() const noexcept
+    {
+        return iterator(_tape, _tape->links[_pos]);
+    }
+
+    size_type size() const noexcept
+    {
+        return _tape->links[_tape->links[_pos]];
+    }
+
+    bool empty() const noexcept
+    {
+        return !size();
+    }
+
+    value_type operator[](size_type n) const noexcept
+    {
+        return *std::next(begin(), n);
+    }
+
+    value_type at(size_type n) const
+    {
+        if (n >= size()) {
+            throw std::out_of_range("htl::json::BasicLazyArray::at");
+        }
+
+        return (*this)[n];
+    }
+
+private:
+    friend class BasicLazyValue<Alloc>;
+
+    const detail::LazyTape<Alloc> *_tape;
+    std::size_t _pos;
+
+    BasicLazyArray(const detail::LazyTape<Alloc> *tape,
+                   std::size_t pos) noexcept
+        : _tape(tape), _pos(pos)
+    {}
+};
+
+// View of the members of a lazy object, in input order. Keys are compared
+// with the text of each member in turn, so lookup is linear in the index.
+template <class Alloc>
+class BasicLazyObject {
+public:
+    using key_type = BasicLazyValue<Alloc>;
+    using mapped_type = BasicLazyValue<Alloc>;
+    using value_type = std::pair<key_type, mapped_type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<key_type, mapped_type>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept : _tape(), _pos() {}
+
+        value_type operator*() const noexcept
+        {
+            return { key_type(_tape, _pos), mapped_type(_tape, _pos + 2) };
+        }
+
+        iterator &operator++() noexcept
+        {
+            _pos = _tape->next_element(_pos, true);
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const iterator &a, const iterator &b) noexcept
+        {
+            return a._pos == b._pos;
+        }
+
+    private:
+        friend class BasicLazyObject;
+
+        const detail::LazyTape<Alloc> *_tape;
+        std::size_t _pos;
+
+        iterator(const detail::LazyTape<Alloc> *tape, std::size_t pos) noexcept
+            : _tape(tape), _pos(pos)
+        {}
+    };
+
+    using const_iterator = iterator;
+
+    iterator begin() const noexcept
+    {
+        return iterator(_tape, _pos + 1);
+    }
+
+    iterator end() const noexcept
+    {
+        return iterator(_tape, _tape->links[_pos]);
+    }
+
+    size_type size() const noexcept
+    {
+        return _tape->links[_tape->links[_pos]];
+    }
+
+    bool empty() const noexcept
+    {
+        return !size();
+    }
+
+    // Finds the member with `key`. Of duplicate keys the last is found, as it
+    // is the one `parse` keeps. Without them, the search stops at the first.
+    iterator find(std::string_view key) const
+    {
+        auto found = end();
+
+        for (auto it = begin(); it != end(); ++it) {
+            if (_tape->key_equals(it._pos, key)) {
+                found = it;
+
+                if (!_tape->opts.accept_duplicate_keys) {
+                    break;
+                }
+            }
+        }
+
+        return found;
+    }
+
+    bool contains(std::string_view key) const
+    {
+        return find(key) != end();
+    }
+
+    mapped_type at(std::string_view key) const
+    {
+        auto it = find(key);
+
+        if (it == end()) {
+            throw std::out_of_range("htl::json::BasicLazyObject::at");
+        }
+
+        return (*it).second;
+    }
+
+    mapped_type operator[](std::string_view key) const
+    {
+        return at(key);
+    }
+
+private:
+    friend class BasicLazyValue<Alloc>;
+
+    const detail::LazyTape<Alloc> *_tape;
+    std::size_t _pos;
+
+    BasicLazyObject(const detail::LazyTape<Alloc> *tape,
+                    std::size_t pos) noexcept
+        : _tape(tape), _pos(pos)
+    {}
+};
+
+// Validated index over JSON text, accessed as its root value. The input is
+// not copied, and must outlive the document and its values. Copies share the
+// index. A document which failed to parse is null.
+template <class Alloc>
+class BasicLazyDocument : public BasicLazyValue<Alloc> {
+public:
+    using allocator_type = Alloc;
+
+    explicit BasicLazyDocument(const Alloc &alloc = Alloc()) noexcept
+        : _owner(), _alloc(alloc)
+    {}
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+private:
+    template <class>
+    friend struct detail::LazyParseHandler;
+
+    std::shared_ptr<const detail::LazyTape<Alloc>> _owner;
+    [[no_unique_address]] Alloc _alloc;
+
+    explicit BasicLazyDocument(
+        std::shared_ptr<const detail::LazyTape<Alloc>> owner) noexcept
+        : BasicLazyValue<Alloc>(owner.get(), 0), _owner(std::move(owner)),
+          _alloc(_owner->alloc)
+    {}
+};
+
+// Indexes contiguous input for on demand access. The whole document is
+// validated, with errors identical to those of `parse`, but no value is
+// decoded until it is accessed. Comments are not supported, and
+// `accept_comments` fails the parse with `ParseErrorCode::UnsupportedOption`.
+template <class I, class S, class Alloc = std::allocator<std::byte>>
+    requires detail::contiguous_input<I, S>
+inline ParseResult<I, BasicLazyDocument<Alloc>>
+parse_lazy(I first, S last, const ParseOptions &opts = ParseOptions(),
+           const Alloc &alloc = Alloc())
+{
+    const char *data = detail::to_char_pointer(first);
+    auto result = detail::LazyParseHandler<Alloc>::parse(
+        data, data + (last - first), opts, alloc);
+
+    return {
+        std::move(first) + (result.in - data),
+        std::move(result.value),
+        result.error,
+    };
+}
+
+template <std::ranges::contiguous_range R,
+          class Alloc = std::allocator<std::byte>>
+    requires detail::contiguous_input<std::ranges::iterator_t<R>,
+                                      std::ranges::sentinel_t<R>>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>,
+                   BasicLazyDocument<Alloc>>
+parse_lazy(R &&r, const ParseOptions &opts = ParseOptions(),
+           const Alloc &alloc = Alloc())
+{
+    return parse_lazy(std::ranges::begin(r), std::ranges::end(r), opts, alloc);
+}
+
+} // namespace htl::json
+
+#endif
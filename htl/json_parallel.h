@@ -0,0 +1,508 @@
+/**
+ * @file htl/json_parallel.h
+ *
+ * Parallel parsing of large top level JSON arrays, and parallel serialization
+ * of large arrays and objects
+ */
+
+#ifndef HTL_JSON_PARALLEL_H_
+#define HTL_JSON_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <htl/json.h>
+#include <htl/scope_guard.h>
+
+namespace htl::json {
+
+struct ParallelParseOptions {
+    // Number of threads, including the calling thread, or 0 for
+    // `std::thread::hardware_concurrency`.
+    std::size_t thread_count = 0;
+
+    // Smallest number of input bytes parsed by one task. Smaller inputs are
+    // parsed serially.
+    std::size_t min_segment_size = std::size_t(1) << 20;
+};
+
+struct ParallelSerializeOptions {
+    // Number of threads, including the calling thread, or 0 for
+    // `std::thread::hardware_concurrency`.
+    std::size_t thread_count = 0;
+
+    // Smallest number of elements serialized by one task. Smaller containers
+    // are serialized serially.
+    std::size_t min_segment_size = 1024;
+};
+
+namespace detail {
+
+// Parses a run of comma separated array elements into `dest`. Unless `is_last`,
+// the run must end at `last`, otherwise it must end with the closing bracket
+// of the array, and `end` is set past it.
+template <class Alloc>
+inline bool parse_array_segment(const char *first, const char *last,
+                                bool is_last, BasicDocument<Alloc> &dest,
+                                const char *&end, const ParseOptions &opts,
+                                const Alloc &alloc)
+{
+    ParseHandler<const char *, const char *, Alloc> handler(
+        first, last, alloc, alloc, opts);
+
+    dest.emplace_array();
+    handler.stack.push_back(std::addressof(dest));
+
+    while (!handler.has_error() && handler.stack.size()) {
+        if (!is_last && handler.stack.size() == 1 &&
+            std::all_of(handler.first, last, is_json_whitespace)) {
+            return !dest.get_array().empty();
+        } else if (handler.stack.size() > opts.max_depth) {
+            return false;
+        }
+
+        handler.continue_document(*handler.stack.back());
+    }
+
+    end = handler.first;
+    return is_last && !handler.has_error() && !dest.get_array().empty();
+}
+
+// Splits a top level array between its elements and parses the pieces
+// concurrently. Returns nothing if the input is not an array, is too small to
+// split, or fails to parse, all of which are left to the serial parser.
+template <class Alloc>
+inline std::optional<ParseResult<const char *, BasicDocument<Alloc>>>
+parse_array_parallel(const char *first, const char *last,
+                     const ParseOptions &opts,
+                     const ParallelParseOptions &parallel_opts,
+                     const Alloc &alloc)
+{
+    std::size_t thread_count = parallel_opts.thread_count
+                                   ? parallel_opts.thread_count
+                                   : std::thread::hardware_concurrency();
+
+    const char *open = std::find_if_not(first, last, is_json_whitespace);
+
+    if (thread_count <= 1 || opts.accept_comments || open == last ||
+        *open != '[') {
+        return std::nullopt;
+    }
+
+    using Offsets = std::vector<
+        std::size_t,
+        typename std::allocator_traits<Alloc>::rebind_alloc<std::size_t>>;
+    using Segments = std::vector<
+        BasicDocument<Alloc>, typename std::allocator_traits<
+                                  Alloc>::rebind_alloc<BasicDocument<Alloc>>>;
+
+    // Several segments per thread, so that uneven ones balance out.
+    std::size_t segment_size =
+        std::max<std::size_t>(parallel_opts.min_segment_size,
+                              (last - open) / (4 * thread_count));
+
+    Offsets splits(alloc);
+    find_array_splits(open, last, segment_size, splits);
+
+    if (splits.empty()) {
+        return std::nullopt;
+    }
+
+    std::size_t segment_count = splits.size() + 1;
+    Segments segments(segment_count, BasicDocument<Alloc>(alloc), alloc);
+    std::atomic<std::size_t> next = 0;
+    std::atomic<bool> failed = false;
+    std::exception_ptr exception;
+    const char *end = last;
+
+    auto work = [&] {
+        try {
+            for (std::size_t i; !failed && (i = next++) < segment_count;) {
+                const char *segment_first = open + 1 + (i ? splits[i - 1] : 0);
+                const char *segment_last =
+                    i + 1 < segment_count ? open + splits[i] : last;
+
+                if (!parse_array_segment(segment_first, segment_last,
+                                         i + 1 == segment_count, segments[i],
+                                         end, opts, alloc)) {
+                    failed = true;
+                }
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                exception = std::current_exception();
+            }
+        }
+    };
+
+    {
+        std::vector<std::thread> threads;
+        ScopeGuard join([&] {
+            for (auto &thread: threads) {
+                thread.join();
+            }
+        });
+
+        thread_count = std::min(thread_count, segment_count);
+        for (std::size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(work);
+        }
+
+        work();
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    } else if (failed) {
+        return std::nullopt;
+    }
+
+    BasicDocument<Alloc> value(alloc);
+    auto &array = value.emplace_array();
+    std::size_t size = 0;
+
+    for (auto &segment: segments) {
+        size += segment.get_array().size();
+    }
+
+    array.reserve(size);
+    for (auto &segment: segments) {
+        for (auto &element: segment.get_array()) {
+            array.push_back(std::move(element));
+        }
+    }
+
+    auto pos = locate(first, end);
+
+    return ParseResult<const char *, BasicDocument<Alloc>>{
+        end,
+        std::move(value),
+        { ParseErrorCode(), pos.line, pos.column, end - first },
+    };
+}
+
+template <class O, class Alloc, class C>
+inline void serialize_container_parallel(
+    SerializeHandler<O, Alloc> &handler, const C &container,
+    std::size_t thread_count, std::size_t min_segment_size, const Alloc &alloc);
+
+template <class O, class Alloc>
+inline void serialize_value_parallel(
+    SerializeHandler<O, Alloc> &handler, const BasicDocument<Alloc> &value,
+    std::size_t thread_count, std::size_t min_segment_size, const Alloc &alloc)
+{
+    if (value.is_array()) {
+        serialize_container_parallel(handler, value.get_array(), thread_count,
+                                     min_segment_size, alloc);
+    } else if (value.is_object()) {
+        serialize_container_parallel(handler, value.get_object(), thread_count,
+                                     min_segment_size, alloc);
+    } else {
+        handler.serialize(value);
+    }
+}
+
+// Serializes a container too small to split, passing through to any element
+// at least `min_segment_size` in size, and to the largest element, so that
+// wrapped containers such as `{"count": 2, "items": [...]}` are split as well.
+template <class O, class Alloc, class C>
+inline void serialize_container_nested(
+    SerializeHandler<O, Alloc> &handler, const C &container,
+    std::size_t thread_count, std::size_t min_segment_size, const Alloc &alloc)
+{
+    constexpr bool is_object = std::same_as<C, BasicObject<Alloc>>;
+    constexpr char open = is_object ? '{' : '[';
+    constexpr char close = is_object ? '}' : ']';
+
+    auto element_value = [](const auto &element) -> auto & {
+        if constexpr (is_object) {
+            return element.second;
+        } else {
+            return element;
+        }
+    };
+
+    auto element_size = [](const BasicDocument<Alloc> &value) -> std::size_t {
+        if (value.is_array()) {
+            return value.get_array().size();
+        } else if (value.is_object()) {
+            return value.get_object().size();
+        } else {
+            return 0;
+        }
+    };
+
+    const BasicDocument<Alloc> *largest = nullptr;
+
+    for (auto &element: container) {
+        auto &value = element_value(element);
+
+        if ((value.is_array() || value.is_object()) &&
+            (!largest || element_size(value) > element_size(*largest))) {
+            largest = std::addressof(value);
+        }
+    }
+
+    if (!largest) {
+        handler.serialize(container);
+        return;
+    }
+
+    bool first = true;
+
+    for (auto &element: container) {
+        auto &value = element_value(element);
+
+        handler.next_element(first ? open : ',', first);
+        first = false;
+
+        if constexpr (is_object) {
+            handler.serialize(element.first);
+            handler.write(':');
+        }
+
+        if (std::addressof(value) == largest ||
+            element_size(value) >= min_segment_size) {
+            serialize_value_parallel(handler, value, thread_count,
+                                     min_segment_size, alloc);
+        } else {
+            handler.serialize(value);
+        }
+    }
+
+    handler.end_container(close);
+}
+
+// Serializes the elements of `container` in segments on several threads, each
+// into its own buffer, and writes the buffers in order.
+template <class O, class Alloc, class C>
+inline void serialize_container_parallel(
+    SerializeHandler<O, Alloc> &handler, const C &container,
+    std::size_t thread_count, std::size_t min_segment_size, const Alloc &alloc)
+{
+    constexpr bool is_object = std::same_as<C, BasicObject<Alloc>>;
+    constexpr char open = is_object ? '{' : '[';
+    constexpr char close = is_object ? '}' : ']';
+
+    auto element_value = [](const auto &element) -> auto & {
+        if constexpr (is_object) {
+            return element.second;
+        } else {
+            return element;
+        }
+    };
+
+    // Several segments per thread, so that uneven ones balance out.
+    std::size_t segment_size = std::max<std::size_t>(
+        { min_segment_size, container.size() / (4 * thread_count), 1 });
+    std::size_t segment_count =
+        (container.size() + segment_size - 1) / segment_size;
+
+    if (segment_count < 2) {
+        serialize_container_nested(handler, container, thread_count,
+                                   min_segment_size, alloc);
+        return;
+    }
+
+    using Iterator = typename C::const_iterator;
+    using Starts = std::vector<
+        Iterator,
+        typename std::allocator_traits<Alloc>::rebind_alloc<Iterator>>;
+    using Buffer = std::vector<
+        char, typename std::allocator_traits<Alloc>::rebind_alloc<char>>;
+    using Buffers = std::vector<
+        Buffer, typename std::allocator_traits<Alloc>::rebind_alloc<Buffer>>;
+
+    Starts starts(alloc);
+    Buffers buffers(segment_count, Buffer(alloc), alloc);
+
+    starts.reserve(segment_count + 1);
+    for (auto it = container.begin(); it != container.end();
+         it = std::ranges::next(it, segment_size, container.end())) {
+        starts.push_back(it);
+    }
+
+    starts.push_back(container.end());
+
+    std::size_t indent_depth = handler.indent_depth + 1;
+    std::atomic<std::size_t> next = 0;
+    std::atomic<bool> failed = false;
+    std::exception_ptr exception;
+
+    auto work = [&] {
+        try {
+            for (std::size_t i; !failed && (i = next++) < segment_count;) {
+                SerializeHandler<std::back_insert_iterator<Buffer>, Alloc>
+                    segment(std::back_inserter(buffers[i]), alloc,
+                            handler.opts);
+
+                segment.indent_depth = indent_depth;
+
+                for (auto it = starts[i]; it != starts[i + 1]; ++it) {
+                    if (i || it != starts[i]) {
+                        segment.write(',');
+                        segment.newline();
+                    }
+
+                    segment.write_indent();
+
+                    if constexpr (is_object) {
+                        segment.serialize(it->first);
+                        segment.write(':');
+                    }
+
+                    segment.serialize(element_value(*it));
+                }
+
+                segment.out.release();
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                exception = std::current_exception();
+            }
+        }
+    };
+
+    {
+        std::vector<std::thread> threads;
+        ScopeGuard join([&] {
+            for (auto &thread: threads) {
+                thread.join();
+            }
+        });
+
+        thread_count = std::min(thread_count, segment_count);
+        for (std::size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(work);
+        }
+
+        work();
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+
+    handler.write(open);
+    handler.indent();
+
+    for (auto &buffer: buffers) {
+        handler.write(std::string_view(buffer.data(), buffer.size()));
+    }
+
+    handler.end_container(close);
+}
+
+template <class O, class Alloc, class T>
+inline O serialize_parallel(
+    const T &value, O out, const SerializeOptions &opts,
+    const ParallelSerializeOptions &parallel_opts, const Alloc &alloc)
+{
+    std::size_t thread_count = parallel_opts.thread_count
+                                   ? parallel_opts.thread_count
+                                   : std::thread::hardware_concurrency();
+    SerializeHandler<O, Alloc> handler(std::move(out), alloc, opts);
+
+    if (thread_count <= 1) {
+        handler.serialize(value);
+    } else if constexpr (std::same_as<T, BasicDocument<Alloc>>) {
+        serialize_value_parallel(handler, value, thread_count,
+                                 parallel_opts.min_segment_size, alloc);
+    } else {
+        serialize_container_parallel(handler, value, thread_count,
+                                     parallel_opts.min_segment_size, alloc);
+    }
+
+    return handler.out.release();
+}
+
+} // namespace detail
+
+// Serializes like `serialize`, splitting large arrays and objects between
+// threads. The output is identical to that of `serialize`.
+//
+// `alloc` is used from every thread at once.
+template <class Alloc, std::output_iterator<char> O>
+inline O serialize_parallel(
+    const BasicDocument<Alloc> &value, O out,
+    const SerializeOptions &opts = SerializeOptions(),
+    const ParallelSerializeOptions &parallel_opts = ParallelSerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return detail::serialize_parallel(value, std::move(out), opts,
+                                      parallel_opts, alloc);
+}
+
+template <class Alloc, std::output_iterator<char> O>
+inline O serialize_parallel(
+    const BasicArray<Alloc> &value, O out,
+    const SerializeOptions &opts = SerializeOptions(),
+    const ParallelSerializeOptions &parallel_opts = ParallelSerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return detail::serialize_parallel(value, std::move(out), opts,
+                                      parallel_opts, alloc);
+}
+
+template <class Alloc, std::output_iterator<char> O>
+inline O serialize_parallel(
+    const BasicObject<Alloc> &value, O out,
+    const SerializeOptions &opts = SerializeOptions(),
+    const ParallelSerializeOptions &parallel_opts = ParallelSerializeOptions(),
+    const Alloc &alloc = Alloc())
+{
+    return detail::serialize_parallel(value, std::move(out), opts,
+                                      parallel_opts, alloc);
+}
+
+// Parses contiguous input like `parse`, splitting a top level array between
+// threads. The result is identical to that of `parse`, which is used for any
+// other input and whenever the array fails to parse.
+//
+// `alloc` is used from every thread at once.
+template <class I, class S, class Alloc = std::allocator<std::byte>>
+    requires detail::contiguous_input<I, S>
+inline ParseResult<I, BasicDocument<Alloc>> parse_parallel(
+    I first, S last, const ParseOptions &opts = ParseOptions(),
+    const ParallelParseOptions &parallel_opts = ParallelParseOptions(),
+    const Alloc &alloc = Alloc())
+{
+    const char *data = detail::to_char_pointer(first);
+
+    if (auto result = detail::parse_array_parallel(
+            data, data + (last - first), opts, parallel_opts, alloc)) {
+        return {
+            std::move(first) + (result->in - data),
+            std::move(result->value),
+            result->error,
+        };
+    }
+
+    return parse(std::move(first), std::move(last), opts, alloc);
+}
+
+template <std::ranges::contiguous_range R,
+          class Alloc = std::allocator<std::byte>>
+    requires detail::contiguous_input<std::ranges::iterator_t<R>,
+                                      std::ranges::sentinel_t<R>>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>, BasicDocument<Alloc>>
+parse_parallel(R &&r, const ParseOptions &opts = ParseOptions(),
+               const ParallelParseOptions &parallel_opts =
+                   ParallelParseOptions(),
+               const Alloc &alloc = Alloc())
+{
+    return parse_parallel(std::ranges::begin(r), std::ranges::end(r), opts,
+                          parallel_opts, alloc);
+}
+
+} // namespace htl::json
+
+#endif
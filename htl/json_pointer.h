@@ -0,0 +1,710 @@
+/**
+ * @file htl/json_pointer.h
+ *
+ * JSON Pointers (RFC 6901) and sets of them resolved together
+ */
+
+#ifndef HTL_JSON_POINTER_H_
+#define HTL_JSON_POINTER_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <htl/ascii.h>
+#include <htl/json.h>
+
+namespace htl::json {
+
+namespace detail {
+
+// A reference token of a pointer, unescaped, with its value as an array index
+// if it is one.
+template <class Alloc>
+struct PointerToken {
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    BasicString<Alloc> key;
+    std::size_t index;
+
+    PointerToken(std::string_view text, const Alloc &alloc)
+        : key(alloc), index(npos)
+    {
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] != '~') {
+                key.push_back(text[i]);
+            } else if (++i < text.size() && text[i] == '0') {
+                key.push_back('~');
+            } else if (i < text.size() && text[i] == '1') {
+                key.push_back('/');
+            } else {
+                throw std::invalid_argument("invalid JSON pointer escape");
+            }
+        }
+
+        if (key.empty() || (key.size() > 1 && key[0] == '0') ||
+            !std::all_of(key.begin(), key.end(), ascii_isdigit)) {
+            return;
+        }
+
+        std::size_t value = 0;
+
+        for (char c: key) {
+            if (value > (npos - 9) / 10) {
+                return;
+            }
+
+            value = value * 10 + (c - '0');
+        }
+
+        index = value;
+    }
+
+    bool operator==(const PointerToken &other) const noexcept
+    {
+        return key == other.key;
+    }
+
+    // The member or element of `value` named by the token, or null.
+    template <class D>
+    D *find(D &value) const
+    {
+        if (value.is_object()) {
+            auto &object = value.get_object();
+            auto pos = object.find(std::string_view(key));
+
+            return pos != object.end() ? std::addressof(pos->second) : nullptr;
+        } else if (value.is_array()) {
+            auto &array = value.get_array();
+
+            return index < array.size() ? std::addressof(array[index])
+                                        : nullptr;
+        }
+
+        return nullptr;
+    }
+};
+
+template <class I, class S, class Alloc, class PointerAlloc>
+struct ProjectParseHandler;
+
+} // namespace detail
+
+// A JSON Pointer, parsed once and resolved against any number of documents.
+// Tokens are unescaped, and array indices converted, on construction.
+template <class Alloc>
+class BasicPointer {
+private:
+    using Token = detail::PointerToken<Alloc>;
+    using Tokens =
+        std::vector<Token,
+                    typename std::allocator_traits<Alloc>::rebind_alloc<Token>>;
+
+    Tokens _tokens;
+
+public:
+    using allocator_type = Alloc;
+    using size_type = std::size_t;
+
+    BasicPointer() noexcept(noexcept(Alloc())) : _tokens() {}
+
+    explicit BasicPointer(const Alloc &alloc) noexcept : _tokens(alloc) {}
+
+    // Throws `std::invalid_argument` if `text` is not a valid pointer.
+    explicit BasicPointer(std::string_view text, const Alloc &alloc = Alloc())
+        : _tokens(alloc)
+    {
+        if (text.empty()) {
+            return;
+        } else if (text[0] != '/') {
+            throw std::invalid_argument("JSON pointer must start with '/'");
+        }
+
+        while (text.size()) {
+            text.remove_prefix(1);
+
+            auto size = std::min(text.find('/'), text.size());
+
+            _tokens.emplace_back(text.substr(0, size), alloc);
+            text.remove_prefix(size);
+        }
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return Alloc(_tokens.get_allocator());
+    }
+
+    size_type size() const noexcept
+    {
+        return _tokens.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return _tokens.empty();
+    }
+
+    // The unescaped reference token at `n`.
+    std::string_view operator[](size_type n) const noexcept
+    {
+        return _tokens[n].key;
+    }
+
+    // The value the pointer refers to within `value`, or null if there is
+    // none.
+    template <class ValueAlloc>
+    BasicDocument<ValueAlloc> *resolve(BasicDocument<ValueAlloc> &value) const
+    {
+        return _resolve(value);
+    }
+
+    template <class ValueAlloc>
+    const BasicDocument<ValueAlloc> *
+    resolve(const BasicDocument<ValueAlloc> &value) const
+    {
+        return _resolve(value);
+    }
+
+    bool operator==(const BasicPointer &other) const noexcept
+    {
+        return std::ranges::equal(_tokens, other._tokens);
+    }
+
+    template <class OtherAlloc>
+    friend class BasicPointerSet;
+
+private:
+    template <class D>
+    D *_resolve(D &value) const
+    {
+        D *pos = std::addressof(value);
+
+        for (auto first = _tokens.begin(); pos && first != _tokens.end();
+             ++first) {
+            pos = first->find(*pos);
+        }
+
+        return pos;
+    }
+};
+
+// A set of pointers resolved in a single traversal. The pointers are kept in
+// a trie, so that a token shared by several of them is looked up only once.
+template <class Alloc>
+class BasicPointerSet {
+private:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    struct Node {
+        detail::PointerToken<Alloc> token;
+        std::size_t first_child;
+        std::size_t next_sibling;
+        std::size_t id;
+    };
+
+    using Nodes =
+        std::vector<Node,
+                    typename std::allocator_traits<Alloc>::rebind_alloc<Node>>;
+
+    // Node 0 is the root, for the empty pointer.
+    Nodes _nodes;
+    std::size_t _size;
+
+public:
+    using allocator_type = Alloc;
+    using size_type = std::size_t;
+
+    BasicPointerSet() : BasicPointerSet(Alloc()) {}
+
+    explicit BasicPointerSet(const Alloc &alloc) : _nodes(alloc), _size(0)
+    {
+        _nodes.push_back({ { {}, alloc }, npos, npos, npos });
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return Alloc(_nodes.get_allocator());
+    }
+
+    // Number of distinct pointers in the set.
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return !_size;
+    }
+
+    // Adds `pointer`, and returns its position in the results of `resolve`.
+    // Adding a pointer twice returns the same position.
+    size_type insert(const BasicPointer<Alloc> &pointer)
+    {
+        std::size_t node = 0;
+
+        for (auto &token: pointer._tokens) {
+            std::size_t *child = &_nodes[node].first_child;
+
+            while (*child != npos && !(_nodes[*child].token == token)) {
+                child = &_nodes[*child].next_sibling;
+            }
+
+            if (*child == npos) {
+                node = *child = _nodes.size();
+                _nodes.push_back({ token, npos, npos, npos });
+            } else {
+                node = *child;
+            }
+        }
+
+        if (_nodes[node].id == npos) {
+            _nodes[node].id = _size++;
+        }
+
+        return _nodes[node].id;
+    }
+
+    size_type insert(std::string_view pointer)
+    {
+        return insert(BasicPointer<Alloc>(pointer, get_allocator()));
+    }
+
+    // Resolves every pointer against `value`, storing the value each refers
+    // to, or null, at its position in `results`, which must hold `size()`
+    // elements.
+    template <class ValueAlloc>
+    void resolve(BasicDocument<ValueAlloc> &value,
+                 std::span<BasicDocument<ValueAlloc> *> results) const
+    {
+        _resolve(0, std::addressof(value), results);
+    }
+
+    template <class ValueAlloc>
+    void resolve(const BasicDocument<ValueAlloc> &value,
+                 std::span<const BasicDocument<ValueAlloc> *> results) const
+    {
+        _resolve(0, std::addressof(value), results);
+    }
+
+    template <class I, class S, class ValueAlloc, class PointerAlloc>
+    friend struct detail::ProjectParseHandler;
+
+private:
+    template <class D>
+    void _resolve(std::size_t node, D *value, std::span<D *> results) const
+    {
+        if (_nodes[node].id != npos) {
+            results[_nodes[node].id] = value;
+        }
+
+        for (std::size_t child = _nodes[node].first_child; child != npos;
+             child = _nodes[child].next_sibling) {
+            _resolve(child, value ? _nodes[child].token.find(*value) : nullptr,
+                     results);
+        }
+    }
+};
+
+namespace detail {
+
+// Parses only the values selected by a set of pointers, along with the
+// objects and arrays enclosing them. Other values are scanned past by
+// counting brackets, without being validated or stored.
+template <class I, class S, class Alloc, class PointerAlloc>
+struct ProjectParseHandler {
+    using Reader = ParseHandler<I, S, Alloc>;
+    using Paths = BasicPointerSet<PointerAlloc>;
+
+    static constexpr std::size_t npos = Paths::npos;
+
+    Reader reader;
+    const Paths &paths;
+    std::size_t depth;
+    std::size_t found;
+    bool stop_when_found;
+
+    ProjectParseHandler(I first, S last, const Paths &paths,
+                        const Alloc &alloc, const ParseOptions &opts,
+                        bool stop_when_found)
+        : reader(std::move(first), std::move(last), alloc, alloc, opts),
+          paths(paths), depth(0), found(0), stop_when_found(stop_when_found)
+    {}
+
+    ParseResult<I, BasicDocument<Alloc>> parse()
+    {
+        BasicDocument<Alloc> value(reader.alloc);
+
+        read(0, value);
+
+        reader.locate_position();
+        return {
+            std::move(reader.first),
+            std::move(value),
+            { reader.code, reader.line, reader.column, reader.offset },
+        };
+    }
+
+    bool stopped()
+    {
+        return stop_when_found && found == paths.size();
+    }
+
+    // Reads the value for `node` into `dest`, and returns whether any
+    // selected value was found within it.
+    bool read(std::size_t node, BasicDocument<Alloc> &dest)
+    {
+        if (stopped() || reader.consume_whitespace_and_comments()) {
+            return false;
+        } else if (paths._nodes[node].id != npos) {
+            read_document(dest);
+            found += count(node);
+            return true;
+        }
+
+        switch (reader.peek()) {
+        case '{':
+            return read_object(node, dest);
+        case '[':
+            return read_array(node, dest);
+        default:
+            skip_value();
+            return false;
+        }
+    }
+
+    bool read_object(std::size_t node, BasicDocument<Alloc> &dest)
+    {
+        BasicObject<Alloc> *object = nullptr;
+        BasicDocument<Alloc> value(reader.alloc);
+
+        if (!start_container()) {
+            return false;
+        }
+
+        for (bool empty = true; !reader.has_error() && !stopped() &&
+                                reader.next_element('}', empty);
+             empty = false) {
+            if (reader.peek() != '"') {
+                reader.set_unexpected_token();
+                break;
+            }
+
+            reader.key_buffer.clear();
+            reader.read_string(reader.key_buffer);
+            if (reader.has_error() ||
+                reader.consume_whitespace_and_comments()) {
+                break;
+            } else if (reader.next() != ':') {
+                reader.set_unexpected_token();
+                break;
+            }
+
+            std::string_view key = reader.key_buffer;
+            std::size_t child = find_key(node, key);
+
+            if (child == npos) {
+                skip_value();
+                continue;
+            }
+
+            bool is_duplicate = object && object->find(key) != object->end();
+
+            if (is_duplicate && !reader.opts.accept_duplicate_keys) {
+                reader.set_duplicate_key();
+                break;
+            }
+
+            // A repeated key replaces the earlier value, as in `parse`, but
+            // is not counted again towards stopping early. Reading the value
+            // reuses the key buffer, so the name is taken from the trie, and
+            // copied only once the value is kept.
+            std::string_view name = paths._nodes[child].token.key;
+            std::size_t prev_found = found;
+
+            if (!read(child, value)) {
+                continue;
+            } else if (is_duplicate) {
+                found = prev_found;
+                object->find(name)->second = std::move(value);
+            } else {
+                if (!object) {
+                    object = std::addressof(dest.emplace_object());
+                }
+
+                object->try_emplace(BasicString<Alloc>(name, reader.alloc),
+                                    std::move(value));
+            }
+
+            value = nullptr;
+        }
+
+        --depth;
+        return object != nullptr;
+    }
+
+    bool read_array(std::size_t node, BasicDocument<Alloc> &dest)
+    {
+        BasicArray<Alloc> *array = nullptr;
+        BasicDocument<Alloc> value(reader.alloc);
+
+        if (!start_container()) {
+            return false;
+        }
+
+        for (std::size_t i = 0; !reader.has_error() && !stopped() &&
+                                reader.next_element(']', !i);
+             ++i) {
+            std::size_t child = find_index(node, i);
+
+            if (child == npos) {
+                skip_value();
+                continue;
+            } else if (!read(child, value)) {
+                continue;
+            } else if (!array) {
+                array = std::addressof(dest.emplace_array());
+            }
+
+            // Elements before a selected one are kept as nulls, so that
+            // indices are the same as in the input.
+            array->resize(i, BasicDocument<Alloc>(reader.alloc));
+            array->push_back(std::move(value));
+            value = nullptr;
+        }
+
+        --depth;
+        return array != nullptr;
+    }
+
+    void read_document(BasicDocument<Alloc> &dest)
+    {
+        std::size_t base = reader.stack.size();
+
+        reader.start_document(dest);
+        while (!reader.has_error() && reader.stack.size() > base) {
+            if (depth + reader.stack.size() - base > reader.opts.max_depth) {
+                reader.set_max_depth();
+                break;
+            }
+
+            reader.continue_document(*reader.stack.back());
+        }
+    }
+
+    bool start_container()
+    {
+        reader.skip();
+        if (++depth > reader.opts.max_depth) {
+            reader.set_max_depth();
+            return false;
+        }
+
+        return true;
+    }
+
+    std::size_t find_key(std::size_t node, std::string_view key)
+    {
+        std::size_t child = paths._nodes[node].first_child;
+
+        while (child != npos &&
+               std::string_view(paths._nodes[child].token.key) != key) {
+            child = paths._nodes[child].next_sibling;
+        }
+
+        return child;
+    }
+
+    std::size_t find_index(std::size_t node, std::size_t index)
+    {
+        std::size_t child = paths._nodes[node].first_child;
+
+        while (child != npos && paths._nodes[child].token.index != index) {
+            child = paths._nodes[child].next_sibling;
+        }
+
+        return child;
+    }
+
+    // Number of pointers in the set selecting `node` or a value within it.
+    std::size_t count(std::size_t node)
+    {
+        std::size_t n = paths._nodes[node].id != npos;
+
+        for (std::size_t child = paths._nodes[node].first_child; child != npos;
+             child = paths._nodes[child].next_sibling) {
+            n += count(child);
+        }
+
+        return n;
+    }
+
+    // Scans past a value, counting brackets but not matching them. Neither
+    // the value nor the nesting depth is validated.
+    void skip_value()
+    {
+        if (reader.consume_whitespace_and_comments()) {
+            return;
+        }
+
+        switch (reader.peek()) {
+        case '"':
+            skip_string();
+            return;
+        case '{':
+        case '[':
+            break;
+        case ',':
+        case ']':
+        case '}':
+            reader.set_unexpected_token();
+            return;
+        default:
+            while (!reader.done() && !is_delimiter(reader.peek())) {
+                reader.skip();
+            }
+            return;
+        }
+
+        for (std::size_t open = 0; !reader.has_error();) {
+            if (reader.done()) {
+                reader.set_unexpected_token();
+                return;
+            }
+
+            switch (reader.peek()) {
+            case '"':
+                skip_string();
+                break;
+            case '{':
+            case '[':
+                reader.skip();
+                ++open;
+                break;
+            case '}':
+            case ']':
+                reader.skip();
+                if (!--open) {
+                    return;
+                }
+                break;
+            case '/':
+            case '\t':
+            case '\n':
+            case '\r':
+            case ' ':
+                reader.consume_whitespace_and_comments();
+                break;
+            default:
+                reader.skip();
+                break;
+            }
+        }
+    }
+
+    void skip_string()
+    {
+        reader.skip();
+        while (!reader.done()) {
+            if constexpr (std::same_as<I, const char *>) {
+                reader.first = find_string_special(reader.first, reader.last);
+                if (reader.done()) {
+                    break;
+                }
+            }
+
+            switch (reader.next()) {
+            case '"':
+                return;
+            case '\\':
+                if (!reader.done()) {
+                    reader.skip();
+                }
+                break;
+            }
+        }
+
+        reader.set_unexpected_token();
+    }
+
+    static bool is_delimiter(char c)
+    {
+        switch (c) {
+        case '\t':
+        case '\n':
+        case '\r':
+        case ' ':
+        case ',':
+        case '/':
+        case ']':
+        case '}':
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+} // namespace detail
+
+// Parses the values selected by `paths`, and the objects and arrays
+// enclosing them, into a document. Selected array elements keep their
+// indices, with nulls before them. Everything else is skipped without being
+// validated or stored, so errors are only reported within selected values,
+// and for the structure leading to them. If nothing is selected, the result
+// is null.
+template <std::input_iterator I, std::sentinel_for<I> S, class PointerAlloc,
+          class Alloc = std::allocator<std::byte>>
+inline ParseResult<I, BasicDocument<Alloc>> parse_projection(
+    I first, S last, const BasicPointerSet<PointerAlloc> &paths,
+    const ParseOptions &opts = ParseOptions(),
+    const ProjectionOptions &projection_opts = ProjectionOptions(),
+    const Alloc &alloc = Alloc())
+{
+    if constexpr (detail::contiguous_input<I, S>) {
+        const char *data = detail::to_char_pointer(first);
+        detail::ProjectParseHandler<const char *, const char *, Alloc,
+                                    PointerAlloc>
+            handler(data, data + (last - first), paths, alloc, opts,
+                    projection_opts.stop_when_found);
+        auto result = handler.parse();
+
+        return {
+            std::move(first) + (result.in - data),
+            std::move(result.value),
+            result.error,
+        };
+    } else {
+        detail::ProjectParseHandler<I, S, Alloc, PointerAlloc> handler(
+            std::move(first), std::move(last), paths, alloc, opts,
+            projection_opts.stop_when_found);
+
+        return handler.parse();
+    }
+}
+
+template <std::ranges::input_range R, class PointerAlloc,
+          class Alloc = std::allocator<std::byte>>
+inline ParseResult<std::ranges::borrowed_iterator_t<R>, BasicDocument<Alloc>>
+parse_projection(R &&r, const BasicPointerSet<PointerAlloc> &paths,
+                 const ParseOptions &opts = ParseOptions(),
+                 const ProjectionOptions &projection_opts = ProjectionOptions(),
+                 const Alloc &alloc = Alloc())
+{
+    return parse_projection(std::ranges::begin(r), std::ranges::end(r), paths,
+                            opts, projection_opts, alloc);
+}
+
+} // namespace htl::json
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file htl/json_writer.h
+ *
+ * Streaming JSON writer
+ */
+
+#ifndef HTL_JSON_WRITER_H_
+#define HTL_JSON_WRITER_H_
+
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <htl/contract.h>
+#include <htl/json.h>
+
+namespace htl::json {
+
+// Writes JSON to `O` as it is produced, without building a document. Calls
+// must form a single value: `key` before each value of an object, and every
+// container ended. Output is buffered until `flush` or `finish`. Misuse is
+// checked with `HTL_EXPECTS`.
+//
+// Only the nesting of containers is kept, one bit per level, so memory does
+// not grow with the size of the output.
+template <std::output_iterator<char> O,
+          class Alloc = std::allocator<std::byte>>
+class Writer {
+public:
+    explicit Writer(O out, const SerializeOptions &opts = SerializeOptions(),
+                    const Alloc &alloc = Alloc())
+        : _handler(std::move(out), alloc, opts), _containers(alloc),
+          _empty(false), _has_key(false), _done(false)
+    {}
+
+    Writer(const Writer &) = delete;
+
+    Writer &operator=(const Writer &) = delete;
+
+    void begin_object()
+    {
+        _begin_value();
+        _containers.push_back(true);
+        _empty = true;
+    }
+
+    void end_object()
+    {
+        HTL_EXPECTS(_containers.size() && _containers.back() && !_has_key);
+        _end_container('{', '}');
+    }
+
+    void begin_array()
+    {
+        _begin_value();
+        _containers.push_back(false);
+        _empty = true;
+    }
+
+    void end_array()
+    {
+        HTL_EXPECTS(_containers.size() && !_containers.back());
+        _end_container('[', ']');
+    }
+
+    void key(std::string_view name)
+    {
+        HTL_EXPECTS(_containers.size() && _containers.back() && !_has_key);
+
+        _handler.next_element(_empty ? '{' : ',', _empty);
+        _handler.serialize_string(name);
+        _handler.write(':');
+        _empty = false;
+        _has_key = true;
+    }
+
+    void value(Null)
+    {
+        _begin_value();
+        _handler.serialize(nullptr);
+    }
+
+    void value(Bool value)
+    {
+        _begin_value();
+        _handler.serialize(value);
+    }
+
+    void value(std::integral auto value)
+    {
+        _begin_value();
+        _handler.serialize(value);
+    }
+
+    void value(std::floating_point auto value)
+    {
+        _begin_value();
+        _handler.serialize(value);
+    }
+
+    void value(std::string_view value)
+    {
+        _begin_value();
+        _handler.serialize_string(value);
+    }
+
+    void value(const char *value)
+    {
+        this->value(std::string_view(value));
+    }
+
+    template <class ValueAlloc>
+    void value(const BasicDocument<ValueAlloc> &value)
+    {
+        _begin_value();
+        _handler.serialize_nested(value);
+    }
+
+    template <class ValueAlloc>
+    void value(const BasicString<ValueAlloc> &value)
+    {
+        _begin_value();
+        _handler.serialize_nested(value);
+    }
+
+    template <class ValueAlloc>
+    void value(const BasicArray<ValueAlloc> &value)
+    {
+        _begin_value();
+        _handler.serialize_nested(value);
+    }
+
+    template <class ValueAlloc>
+    void value(const BasicObject<ValueAlloc> &value)
+    {
+        _begin_value();
+        _handler.serialize_nested(value);
+    }
+
+    // Writes the buffered output to the destination.
+    void flush()
+    {
+        _handler.out.flush();
+    }
+
+    // Flushes the output of the completed value and returns the destination
+    // past it.
+    O finish()
+    {
+        HTL_EXPECTS(_done && !_containers.size());
+        return _handler.out.release();
+    }
+
+private:
+    detail::SerializeHandler<O, Alloc> _handler;
+    detail::BitStack<Alloc> _containers;
+    bool _empty;
+    bool _has_key;
+    bool _done;
+
+    void _begin_value()
+    {
+        if (!_containers.size()) {
+            HTL_EXPECTS(!_done);
+            _done = true;
+        } else if (_containers.back()) {
+            HTL_EXPECTS(_has_key);
+            _has_key = false;
+        } else {
+            _handler.next_element(_empty ? '[' : ',', _empty);
+            _empty = false;
+        }
+    }
+
+    void _end_container(char open, char close)
+    {
+        if (_empty) {
+            _handler.write(open);
+            _handler.write(close);
+        } else {
+            _handler.end_container(close);
+        }
+
+        _containers.pop_back();
+        _empty = false;
+    }
+};
+
+} // namespace htl::json
+
+#endif
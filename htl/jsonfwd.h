@@ -47,15 +47,52 @@ class BasicObject;
 template <class Alloc>
 class BasicParser;
 
+template <class Alloc>
+class BasicIncrementalParser;
+
 template <class Alloc>
 class BasicSerializer;
 
+template <class Alloc>
+class BasicChunkedSerializer;
+
+template <class Alloc>
+class BasicPointer;
+
+template <class Alloc>
+class BasicPointerSet;
+
+template <class Alloc>
+class BasicLazyValue;
+
+template <class Alloc>
+class BasicLazyArray;
+
+template <class Alloc>
+class BasicLazyObject;
+
+template <class Alloc>
+class BasicLazyDocument;
+
+class Arena;
+
+template <class T>
+class ArenaAllocator;
+
 using Document = BasicDocument<std::allocator<std::byte>>;
 using String = BasicString<std::allocator<std::byte>>;
 using Array = BasicArray<std::allocator<std::byte>>;
 using Object = BasicObject<std::allocator<std::byte>>;
 using Parser = BasicParser<std::allocator<std::byte>>;
+using IncrementalParser = BasicIncrementalParser<std::allocator<std::byte>>;
 using Serializer = BasicSerializer<std::allocator<std::byte>>;
+using ChunkedSerializer = BasicChunkedSerializer<std::allocator<std::byte>>;
+using Pointer = BasicPointer<std::allocator<std::byte>>;
+using PointerSet = BasicPointerSet<std::allocator<std::byte>>;
+using LazyValue = BasicLazyValue<std::allocator<std::byte>>;
+using LazyArray = BasicLazyArray<std::allocator<std::byte>>;
+using LazyObject = BasicLazyObject<std::allocator<std::byte>>;
+using LazyDocument = BasicLazyDocument<std::allocator<std::byte>>;
 
 namespace pmr {
 
@@ -64,10 +101,32 @@ using String = BasicString<std::pmr::polymorphic_allocator<std::byte>>;
 using Array = BasicArray<std::pmr::polymorphic_allocator<std::byte>>;
 using Object = BasicObject<std::pmr::polymorphic_allocator<std::byte>>;
 using Parser = BasicParser<std::pmr::polymorphic_allocator<std::byte>>;
+using IncrementalParser =
+    BasicIncrementalParser<std::pmr::polymorphic_allocator<std::byte>>;
 using Serializer = BasicSerializer<std::pmr::polymorphic_allocator<std::byte>>;
+using ChunkedSerializer =
+    BasicChunkedSerializer<std::pmr::polymorphic_allocator<std::byte>>;
+using Pointer = BasicPointer<std::pmr::polymorphic_allocator<std::byte>>;
+using PointerSet =
+    BasicPointerSet<std::pmr::polymorphic_allocator<std::byte>>;
+using LazyValue = BasicLazyValue<std::pmr::polymorphic_allocator<std::byte>>;
+using LazyArray = BasicLazyArray<std::pmr::polymorphic_allocator<std::byte>>;
+using LazyObject = BasicLazyObject<std::pmr::polymorphic_allocator<std::byte>>;
+using LazyDocument =
+    BasicLazyDocument<std::pmr::polymorphic_allocator<std::byte>>;
 
 } // namespace pmr
 
+namespace arena {
+
+using Document = BasicDocument<ArenaAllocator<std::byte>>;
+using String = BasicString<ArenaAllocator<std::byte>>;
+using Array = BasicArray<ArenaAllocator<std::byte>>;
+using Object = BasicObject<ArenaAllocator<std::byte>>;
+using Parser = BasicParser<ArenaAllocator<std::byte>>;
+
+} // namespace arena
+
 enum class ParseErrorCode {
     None,
     UnexpectedToken,
@@ -76,6 +135,9 @@ enum class ParseErrorCode {
     MaxDepth,
     NumberOutOfRange,
     DuplicateKey,
+    Aborted,
+    TypeMismatch,
+    UnsupportedOption,
 };
 
 struct ParseOptions {
@@ -85,6 +147,18 @@ struct ParseOptions {
     bool accept_trailing_commas = false;
     bool accept_comments = false;
     bool accept_duplicate_keys = false;
+
+    // Keep numbers in contiguous input as their text, converted only when
+    // read and serialized unchanged. The input must then outlive the
+    // document, and numbers are not checked against the range of `Int` or
+    // `Float`.
+    bool lazy_numbers = false;
+};
+
+// Options of `parse_projection`. With `stop_when_found`, parsing stops as
+// soon as every pointer has been found, just past the last selected value.
+struct ProjectionOptions {
+    bool stop_when_found = false;
 };
 
 struct ParseError;
@@ -92,6 +166,9 @@ struct ParseError;
 template <class I, class T>
 struct ParseResult;
 
+template <class I>
+struct ParseEventsResult;
+
 struct SerializeOptions {
     std::size_t indent_size = 0;
 };
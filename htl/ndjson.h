@@ -0,0 +1,281 @@
+/**
+ * @file htl/ndjson.h
+ *
+ * Parallel parsing of newline delimited JSON
+ */
+
+#ifndef HTL_NDJSON_H_
+#define HTL_NDJSON_H_
+
+#include <algorithm>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <htl/json.h>
+#include <htl/scope_guard.h>
+
+namespace htl::json {
+
+struct NdjsonOptions {
+    // Number of worker threads, or 0 for `std::thread::hardware_concurrency`.
+    std::size_t thread_count = 0;
+
+    // Approximate number of input bytes in each batch of lines handed to a
+    // worker. Batches always end at a line boundary.
+    std::size_t batch_size = std::size_t(1) << 20;
+};
+
+namespace detail {
+
+template <class Alloc>
+struct NdjsonBatch {
+    using Result = ParseResult<std::size_t, BasicDocument<Alloc>>;
+    using Results = std::vector<
+        Result, typename std::allocator_traits<Alloc>::rebind_alloc<Result>>;
+
+    explicit NdjsonBatch(const Alloc &alloc)
+        : first(), last(), line_count(), results(alloc), exception(),
+          ready()
+    {}
+
+    const char *first;
+    const char *last;
+    std::size_t line_count;
+    Results results;
+    std::exception_ptr exception;
+    bool ready;
+};
+
+// Splits `input` after the first newline following every `batch_size` bytes.
+template <class Batches>
+inline void split_ndjson_batches(
+    std::string_view input, std::size_t batch_size, Batches &dest)
+{
+    const char *pos = input.data();
+    const char *last = pos + input.size();
+
+    batch_size = std::max<std::size_t>(batch_size, 1);
+
+    while (pos != last) {
+        const char *end = last - pos > batch_size ? pos + batch_size : last;
+
+        end = std::find(end, last, '\n');
+        end += end != last;
+
+        auto &batch = dest.emplace_back(dest.get_allocator());
+        batch.first = pos;
+        batch.last = end;
+        pos = end;
+    }
+}
+
+// Parses each line of the batch. Blank lines are skipped, and each result
+// holds the index of its line within the batch. Error offsets are from
+// `origin`.
+template <class Alloc>
+inline void parse_ndjson_batch(NdjsonBatch<Alloc> &batch, const char *origin,
+                               const ParseOptions &opts, const Alloc &alloc)
+{
+    BasicParser<Alloc> parser(opts, alloc);
+    std::size_t line = 0;
+
+    for (const char *pos = batch.first; pos != batch.last; ++line) {
+        const char *end = std::find(pos, batch.last, '\n');
+
+        if (!std::all_of(pos, end, is_json_whitespace)) {
+            auto result = parser.parse(pos, end);
+            auto rest = std::find_if_not(result.in, end, is_json_whitespace);
+            ParseError error = result.error;
+
+            if (!error && rest != end) {
+                error = ParseError(ParseErrorCode::UnexpectedToken, 0,
+                                   rest - pos, rest - pos);
+            }
+
+            if (error) {
+                error = ParseError(error.code(), 0, error.column(),
+                                   error.offset() + (pos - origin));
+            }
+
+            batch.results.push_back({ line, std::move(result.value), error });
+        }
+
+        pos = end + (end != batch.last);
+    }
+
+    batch.line_count = line;
+}
+
+template <class Alloc, class F>
+inline void deliver_ndjson_batch(
+    NdjsonBatch<Alloc> &batch, std::size_t first_line, F &callback)
+{
+    for (auto &[line, value, error]: batch.results) {
+        if (error) {
+            error = ParseError(error.code(), first_line + line,
+                               error.column(), error.offset());
+        }
+
+        std::invoke(callback, first_line + line, std::move(value),
+                    std::as_const(error));
+    }
+
+    batch.results.clear();
+    batch.results.shrink_to_fit();
+}
+
+} // namespace detail
+
+// Parses newline delimited JSON, one document per line, on a pool of worker
+// threads. Blank lines are skipped.
+//
+// `callback` is invoked on the calling thread in input order as
+// `callback(line, value, error)`, with the zero based line index, the parsed
+// document, and the error for the line. Error positions are those within the
+// whole input. Workers run at most two batches per thread ahead of the
+// callback, which bounds memory use.
+//
+// `alloc` is used from every worker thread at once.
+template <class F, class Alloc = std::allocator<std::byte>>
+    requires std::invocable<F &, std::size_t, BasicDocument<Alloc> &&,
+                            const ParseError &>
+inline void parse_ndjson(std::string_view input, F &&callback,
+                         const ParseOptions &opts = ParseOptions(),
+                         const NdjsonOptions &ndjson_opts = NdjsonOptions(),
+                         const Alloc &alloc = Alloc())
+{
+    using Batch = detail::NdjsonBatch<Alloc>;
+    using Batches = std::vector<
+        Batch, typename std::allocator_traits<Alloc>::rebind_alloc<Batch>>;
+
+    Batches batches(alloc);
+    detail::split_ndjson_batches(input, ndjson_opts.batch_size, batches);
+
+    std::size_t thread_count = ndjson_opts.thread_count
+                                   ? ndjson_opts.thread_count
+                                   : std::thread::hardware_concurrency();
+
+    thread_count = std::min(thread_count, batches.size());
+
+    if (thread_count <= 1) {
+        std::size_t line = 0;
+
+        for (auto &batch: batches) {
+            detail::parse_ndjson_batch(batch, input.data(), opts, alloc);
+            detail::deliver_ndjson_batch(batch, line, callback);
+            line += batch.line_count;
+        }
+
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t next = 0;
+    std::size_t delivered = 0;
+    std::size_t window = 2 * thread_count;
+    bool stop = false;
+
+    auto work = [&] {
+        while (true) {
+            std::unique_lock lock(mutex);
+
+            cv.wait(lock, [&] {
+                return stop || next == batches.size() ||
+                       next < delivered + window;
+            });
+
+            if (stop || next == batches.size()) {
+                return;
+            }
+
+            auto &batch = batches[next++];
+            lock.unlock();
+
+            try {
+                detail::parse_ndjson_batch(batch, input.data(), opts, alloc);
+            } catch (...) {
+                batch.exception = std::current_exception();
+            }
+
+            lock.lock();
+            batch.ready = true;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    ScopeGuard join([&] {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+
+        cv.notify_all();
+
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    });
+
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back(work);
+    }
+
+    std::size_t line = 0;
+
+    for (auto &batch: batches) {
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [&] { return batch.ready; });
+        }
+
+        if (batch.exception) {
+            std::rethrow_exception(batch.exception);
+        }
+
+        detail::deliver_ndjson_batch(batch, line, callback);
+        line += batch.line_count;
+
+        {
+            std::lock_guard lock(mutex);
+            ++delivered;
+        }
+
+        cv.notify_all();
+    }
+}
+
+// Parses newline delimited JSON as above, returning the results in input
+// order. The `in` member of each result is its zero based line index.
+template <class Alloc = std::allocator<std::byte>>
+inline std::vector<ParseResult<std::size_t, BasicDocument<Alloc>>>
+parse_ndjson(std::string_view input, const ParseOptions &opts = ParseOptions(),
+             const NdjsonOptions &ndjson_opts = NdjsonOptions(),
+             const Alloc &alloc = Alloc())
+{
+    std::vector<ParseResult<std::size_t, BasicDocument<Alloc>>> results;
+
+    parse_ndjson(
+        input,
+        [&](std::size_t line, BasicDocument<Alloc> &&value,
+            const ParseError &error) {
+            results.push_back({ line, std::move(value), error });
+        },
+        opts, ndjson_opts, alloc);
+
+    return results;
+}
+
+} // namespace htl::json
+
+#endif
@@ -1,7 +1,18 @@
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <memory_resource>
+#include <random>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <gtest/gtest.h>
 #include <htl/json.h>
+#include <htl/md5.h>
 #include <htl/utility.h>
 #include "./test_json.h"
 
@@ -288,4 +299,953 @@ TEST(JSONTest, Parse)
     }
 }
 
+TEST(JSONTest, ParseNonContiguous)
+{
+    TestAlloc alloc(1);
+
+    for (auto &test_case: parse_success_cases) {
+        std::list<char> input(test_case.input.begin(), test_case.input.end());
+        auto result = parse(input, test_case.opts, alloc);
+        auto expected = parse(test_case.input, test_case.opts, alloc);
+
+        ASSERT_FALSE(result.error);
+        ASSERT_EQ(result.value, test_case.value);
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+        ASSERT_EQ(std::string(result.in, input.end()), test_case.remaining)
+            << test_case.name;
+    }
+
+    for (auto &test_case: parse_fail_cases) {
+        std::list<char> input(test_case.input.begin(), test_case.input.end());
+        auto result = parse(input, test_case.opts, alloc);
+        auto expected = parse(test_case.input, test_case.opts, alloc);
+
+        ASSERT_EQ(result.error.code(), test_case.code);
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+        ASSERT_EQ(result.error.offset(), expected.error.offset());
+    }
+}
+
+TEST(JSONTest, ParseErrorPosition)
+{
+    std::string input = "[1,\r\n  2,\n  x]";
+    std::list<char> list_input(input.begin(), input.end());
+
+    for (auto error: { parse(input).error, parse(list_input).error }) {
+        ASSERT_EQ(error.code(), ParseErrorCode::UnexpectedToken);
+        ASSERT_EQ(error.line(), 2);
+        ASSERT_EQ(error.column(), 2);
+        ASSERT_EQ(error.offset(), 12);
+    }
+
+    auto result = parse(input.substr(0, 4));
+
+    ASSERT_EQ(result.error.code(), ParseErrorCode::UnexpectedToken);
+    ASSERT_EQ(result.error.line(), 1);
+    ASSERT_EQ(result.error.column(), 0);
+    ASSERT_EQ(result.error.offset(), 4);
+
+    std::string valid = "[1,\r\n  2,\n  3] x";
+    std::list<char> list_valid(valid.begin(), valid.end());
+    struct Handler {
+    } handler;
+
+    for (auto error: { parse(valid).error, parse(list_valid).error,
+                       parse(valid, { .accept_comments = true }).error,
+                       validate(valid).error, validate(list_valid).error,
+                       parse_events(valid, handler).error }) {
+        ASSERT_EQ(error.code(), ParseErrorCode::None);
+        ASSERT_EQ(error.line(), 2);
+        ASSERT_EQ(error.column(), 4);
+        ASSERT_EQ(error.offset(), 14);
+    }
+}
+
+TEST(JSONTest, ParseIntegers)
+{
+    std::string digits = "1234567890123456789";
+
+    for (std::size_t i = 1; i <= digits.size(); ++i) {
+        std::string input = digits.substr(0, i);
+        std::list<char> list_input(input.begin(), input.end());
+        Int expected = std::stoll(input);
+
+        ASSERT_EQ(parse(input).value, expected);
+        ASSERT_EQ(parse(list_input).value, expected);
+        ASSERT_EQ(parse("-" + input).value, -expected);
+    }
+
+    ASSERT_EQ(parse("9223372036854775807"s).value,
+              std::numeric_limits<Int>::max());
+    ASSERT_EQ(parse("-9223372036854775808"s).value,
+              std::numeric_limits<Int>::min());
+
+    for (auto input: { "9223372036854775808"s, "-9223372036854775809"s,
+                       "9999999999999999999"s, "12345678901234567890"s }) {
+        std::list<char> list_input(input.begin(), input.end());
+
+        ASSERT_EQ(parse(input).error.code(), ParseErrorCode::NumberOutOfRange);
+        ASSERT_EQ(parse(list_input).error.code(),
+                  ParseErrorCode::NumberOutOfRange);
+    }
+}
+
+TEST(JSONTest, ParseLongNumbers)
+{
+    TestAlloc alloc(1);
+    std::string input = "[0." + std::string(100, '0') + "1, 1" +
+                        std::string(100, '0') + "e-100]";
+    std::list<char> list_input(input.begin(), input.end());
+    TestDocument expected(TestArray({ 1e-101, 1.0 }, alloc), alloc);
+
+    ASSERT_EQ(parse(input, alloc).value, expected);
+    ASSERT_EQ(parse(list_input, alloc).value, expected);
+}
+
+TEST(JSONTest, ParseStringRuns)
+{
+    const std::string pieces[] = {
+        "a",    "0123456789abcdef", "\\n",        "\\u00e9",
+        "\xC3\xA9", "\xE2\x82\xAC",       "\xF0\x9F\x98\x80", "\xC0\x80",
+        "\xED\xA0\x80", "\xEF\xBF\xBF",      "\xF4\x90\x80\x80", "\xE2\x82",
+        "\x80", "\x7F",
+    };
+
+    ParseOptions replace_opts;
+    replace_opts.accept_invalid_code_points = true;
+    replace_opts.replace_invalid_code_points = true;
+
+    std::mt19937 engine;
+    std::uniform_int_distribution<std::size_t> dist(0, std::size(pieces) - 1);
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string input = "\"";
+
+        for (int j = i % 40; j >= 0; --j) {
+            input += pieces[dist(engine)];
+        }
+
+        input += "\"";
+
+        for (auto &opts: { ParseOptions(), replace_opts }) {
+            std::list<char> list_input(input.begin(), input.end());
+            auto result = parse(input, opts);
+            auto expected = parse(list_input, opts);
+
+            ASSERT_EQ(result.error.code(), expected.error.code());
+            ASSERT_EQ(result.error.offset(), expected.error.offset());
+            ASSERT_EQ(result.value, expected.value);
+        }
+    }
+}
+
+// Rebuilds a document from parse events.
+struct EventBuilder {
+    TestDocument value;
+    std::vector<TestDocument *> stack;
+    TestString key;
+
+    TestDocument &next()
+    {
+        if (stack.empty()) {
+            return value;
+        } else if (stack.back()->is_array()) {
+            return stack.back()->get_array().emplace_back();
+        } else {
+            return stack.back()->get_object()[key];
+        }
+    }
+
+    void on_null()
+    {
+        next() = nullptr;
+    }
+
+    void on_bool(Bool v)
+    {
+        next() = v;
+    }
+
+    void on_int(Int v)
+    {
+        next() = v;
+    }
+
+    void on_float(Float v)
+    {
+        next() = v;
+    }
+
+    void on_string(std::string_view v)
+    {
+        next() = v;
+    }
+
+    void on_key(std::string_view v)
+    {
+        key = v;
+    }
+
+    void on_start_array()
+    {
+        auto &dest = next();
+        dest.emplace_array();
+        stack.push_back(&dest);
+    }
+
+    void on_start_object()
+    {
+        auto &dest = next();
+        dest.emplace_object();
+        stack.push_back(&dest);
+    }
+
+    void on_end_array()
+    {
+        stack.pop_back();
+    }
+
+    void on_end_object()
+    {
+        stack.pop_back();
+    }
+};
+
+TEST(JSONTest, ParseEvents)
+{
+    for (auto &test_case: parse_success_cases) {
+        std::list<char> list_input(test_case.input.begin(),
+                                   test_case.input.end());
+        EventBuilder builder, list_builder;
+        auto result = parse_events(test_case.input, builder, test_case.opts);
+        auto list_result =
+            parse_events(list_input, list_builder, test_case.opts);
+
+        ASSERT_FALSE(result.error);
+        ASSERT_FALSE(list_result.error);
+        ASSERT_EQ(builder.value, test_case.value);
+        ASSERT_EQ(list_builder.value, test_case.value);
+        ASSERT_EQ(std::string(result.in, test_case.input.end()),
+                  test_case.remaining);
+    }
+
+    for (auto &test_case: parse_fail_cases) {
+        if (test_case.code == ParseErrorCode::DuplicateKey) {
+            continue;
+        }
+
+        EventBuilder builder;
+        auto result = parse_events(test_case.input, builder, test_case.opts);
+        auto expected = parse(test_case.input, test_case.opts);
+
+        ASSERT_EQ(result.error.code(), test_case.code);
+        ASSERT_EQ(result.error.offset(), expected.error.offset());
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+    }
+}
+
+TEST(JSONTest, ParseEventsAbort)
+{
+    struct Handler {
+        int count = 0;
+
+        bool on_int(Int)
+        {
+            return ++count < 2;
+        }
+    } handler;
+
+    std::string input = "[1, \"a\", 2, 3]";
+    auto result = parse_events(input, handler);
+
+    ASSERT_EQ(result.error.code(), ParseErrorCode::Aborted);
+    ASSERT_EQ(result.error.offset(), 10);
+    ASSERT_EQ(handler.count, 2);
+}
+
+TEST(JSONTest, IncrementalParse)
+{
+    TestAlloc alloc(1);
+
+    for (std::size_t chunk_size: { 1, 2, 3, 7, 64 }) {
+        auto feed = [&](std::string_view input, const ParseOptions &opts) {
+            BasicIncrementalParser<TestAlloc> parser(opts, alloc);
+            ParseError error;
+
+            for (std::size_t i = 0; i < input.size(); i += chunk_size) {
+                error = parser.feed(input.substr(i, chunk_size));
+            }
+
+            auto result = parser.finish();
+
+            if (!error) {
+                error = result.error;
+            }
+
+            EXPECT_EQ(error.code(), result.error.code());
+            return result;
+        };
+
+        for (auto &test_case: parse_success_cases) {
+            auto result = feed(test_case.input, test_case.opts);
+
+            auto expected = parse(test_case.input, test_case.opts);
+
+            ASSERT_FALSE(result.error);
+            ASSERT_EQ(result.value, test_case.value);
+            ASSERT_EQ(result.in,
+                      test_case.input.size() - test_case.remaining.size());
+            ASSERT_EQ(result.error.line(), expected.error.line());
+            ASSERT_EQ(result.error.column(), expected.error.column());
+            ASSERT_EQ(result.error.offset(), expected.error.offset());
+        }
+
+        for (auto &test_case: parse_fail_cases) {
+            auto result = feed(test_case.input, test_case.opts);
+            auto expected = parse(test_case.input, test_case.opts);
+
+            ASSERT_EQ(result.error.code(), test_case.code);
+            ASSERT_EQ(result.error.line(), expected.error.line());
+            ASSERT_EQ(result.error.column(), expected.error.column());
+            ASSERT_EQ(result.error.offset(), expected.error.offset());
+        }
+    }
+}
+
+TEST(JSONTest, ParseBlockBoundaries)
+{
+    TestAlloc alloc(1);
+
+    for (int shift = 0; shift < 130; ++shift) {
+        std::string input = "[\"" + std::string(shift, 'x') + "\", ";
+
+        input += "\"a\\\\\\\\\", {\"\\\"k\\\\\": [1, -2.5e3, true]}, ";
+        input += "\"" + std::string(shift % 7, '\\') +
+                 std::string(shift % 7, '\\') + "\", null\n]";
+
+        std::list<char> list_input(input.begin(), input.end());
+        auto result = parse(input, alloc);
+        auto expected = parse(list_input, alloc);
+
+        ASSERT_FALSE(result.error);
+        ASSERT_FALSE(expected.error);
+        ASSERT_EQ(result.value, expected.value);
+        ASSERT_EQ(result.value.get_array().size(), 5);
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+    }
+}
+
+TEST(JSONTest, ParseInSitu)
+{
+    TestAlloc alloc(1);
+
+    for (auto &test_case: parse_success_cases) {
+        std::string input = test_case.input;
+        auto result = parse_in_situ(input, test_case.opts, alloc);
+
+        ASSERT_FALSE(result.error);
+        ASSERT_EQ(result.value, test_case.value);
+        ASSERT_EQ(result.in - input.data(),
+                  input.size() - test_case.remaining.size());
+    }
+
+    for (auto &test_case: parse_fail_cases) {
+        std::string input = test_case.input;
+        auto result = parse_in_situ(input, test_case.opts, alloc);
+        auto expected = parse(test_case.input, test_case.opts, alloc);
+
+        ASSERT_EQ(result.error.code(), test_case.code);
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+        ASSERT_EQ(result.error.offset(), expected.error.offset());
+    }
+}
+
+TEST(JSONTest, ParseInSituBorrowed)
+{
+    std::string input = R"(["abc", "a\nb\u00e9\n", {"k\n": "x\ty"}])";
+    auto [in, doc, error] = parse_in_situ(input);
+
+    ASSERT_FALSE(error);
+
+    auto &array = doc.get_array();
+
+    ASSERT_TRUE(array[0].is_borrowed());
+    ASSERT_EQ(array[0].get_string_view(), "abc");
+    ASSERT_EQ(array[0].get_string_view().data(), input.data() + 2);
+    ASSERT_TRUE(array[1].is_borrowed());
+    ASSERT_EQ(array[1].get_string_view(), "a\nb\u00e9\n");
+    ASSERT_EQ(array[1].get_string_view().data(), input.data() + 9);
+    ASSERT_EQ(array[2].get_object().at("k\n").get_string_view(), "x\ty");
+
+    Document copy = array[1];
+    Document moved = std::move(copy);
+
+    ASSERT_TRUE(moved.is_borrowed());
+    ASSERT_FALSE(copy.is_borrowed());
+    ASSERT_EQ(moved, array[1]);
+
+    copy = moved;
+    ASSERT_TRUE(copy.is_borrowed());
+    copy = 1;
+    ASSERT_FALSE(copy.is_borrowed());
+    ASSERT_EQ(copy, 1);
+
+    moved.get_string() += "!";
+    ASSERT_FALSE(moved.is_borrowed());
+    ASSERT_EQ(moved.get_string_view(), "a\nb\u00e9\n!");
+    ASSERT_EQ(array[1].get_string_view(), "a\nb\u00e9\n");
+
+    const Document &borrowed = array[0];
+
+    ASSERT_TRUE(borrowed.is_borrowed());
+    ASSERT_EQ(borrowed.get_string_view(), "abc");
+    ASSERT_EQ(std::as_const(array)[0].get_string_view(), "abc");
+}
+
+TEST(JSONDeathTest, BorrowedGetString)
+{
+    std::string input = R"(["abc"])";
+    const Document doc = parse_in_situ(input).value;
+
+    ASSERT_DEATH(doc.get_array()[0].get_string(), "precondition");
+    ASSERT_DEATH(std::move(doc.get_array()[0]).get_string(), "precondition");
+}
+
+TEST(JSONTest, Validate)
+{
+    // Validating contiguous input must not allocate for documents of
+    // ordinary depth and size, unless they have comments.
+    std::pmr::polymorphic_allocator<std::byte> null_alloc(
+        std::pmr::null_memory_resource());
+
+    auto validate_contiguous = [&](const std::string &input,
+                                   const ParseOptions &opts) {
+        return opts.accept_comments ? validate(input, opts)
+                                    : validate(input, opts, null_alloc);
+    };
+
+    for (auto &test_case: parse_success_cases) {
+        std::list<char> list_input(test_case.input.begin(),
+                                   test_case.input.end());
+        auto result = validate_contiguous(test_case.input, test_case.opts);
+        auto list_result = validate(list_input, test_case.opts);
+
+        ASSERT_FALSE(result.error) << test_case.input;
+        ASSERT_FALSE(list_result.error);
+        ASSERT_EQ(std::string(result.in, test_case.input.end()),
+                  test_case.remaining);
+        ASSERT_EQ(std::string(list_result.in, list_input.end()),
+                  test_case.remaining);
+    }
+
+    for (auto &test_case: parse_fail_cases) {
+        std::list<char> list_input(test_case.input.begin(),
+                                   test_case.input.end());
+        auto expected = parse(test_case.input, test_case.opts);
+
+        for (auto error: {
+                 validate(test_case.input, test_case.opts).error,
+                 validate(list_input, test_case.opts).error,
+             }) {
+            ASSERT_EQ(error.code(), test_case.code) << test_case.input;
+            ASSERT_EQ(error.offset(), expected.error.offset());
+            ASSERT_EQ(error.line(), expected.error.line());
+            ASSERT_EQ(error.column(), expected.error.column());
+        }
+    }
+
+    // Every case within an array, at each offset of a SIMD block, so that
+    // strings, escapes and UTF-8 sequences cross the blocks.
+    for (std::size_t pad = 0; pad < 64; ++pad) {
+        auto check = [&](const std::string &input, const ParseOptions &opts) {
+            std::string wrapped = "[" + std::string(pad, ' ') + input + "]";
+            auto expected = parse(wrapped, opts).error;
+            auto error = validate(wrapped, opts).error;
+
+            ASSERT_EQ(error.code(), expected.code()) << wrapped;
+            ASSERT_EQ(error.offset(), expected.offset());
+        };
+
+        for (auto &test_case: parse_success_cases) {
+            check(test_case.input, test_case.opts);
+        }
+
+        for (auto &test_case: parse_fail_cases) {
+            check(test_case.input, test_case.opts);
+        }
+    }
+
+    std::string deep = std::string(300, '[') + "{\"a\": [1]}" +
+                       std::string(300, ']');
+
+    ASSERT_FALSE(validate(deep).error);
+    ASSERT_EQ(validate(deep, { .max_depth = 300 }).error.code(),
+              ParseErrorCode::MaxDepth);
+
+    std::string truncated = deep.substr(0, deep.size() - 1);
+    std::string mismatched = deep.substr(0, 305) + "[]]";
+
+    ASSERT_EQ(validate(truncated).error.code(),
+              ParseErrorCode::UnexpectedToken);
+    ASSERT_EQ(validate(mismatched).error.code(),
+              ParseErrorCode::UnexpectedToken);
+    ASSERT_EQ(validate(mismatched).error.offset(),
+              parse(mismatched).error.offset());
+
+    // Keys only clash within one object, including once decoded.
+    std::string keys = R"([{"a": {"a": 1, "b": [{"a": 2}]}, "b": 3},)"
+                       R"( {"a": 4, "b": {}}, {"c": 5, "\u0061": 6}])";
+    std::string dup = R"({"a": {"b": 1, "c": 2}, "b": [], "a": null})";
+    std::string large = "{";
+    std::string large_dup;
+
+    // Enough keys to be indexed rather than searched.
+    for (int i = 0; i < 40; ++i) {
+        large += "\"k" + std::to_string(i) + "\": {\"k1\": 1}, ";
+    }
+
+    large_dup = large + "\"k30\": 1}";
+    large += "\"k\": 1}";
+
+    // More keys than are kept without allocating.
+    std::string huge = "{";
+    std::string huge_dup;
+
+    for (int i = 0; i < 300; ++i) {
+        huge += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+    }
+
+    huge_dup = huge + "\"k\u0031\": 1}";
+    huge += "\"k\": 1}";
+
+    for (auto &input: { keys, dup, large, large_dup, huge, huge_dup }) {
+        std::list<char> list_input(input.begin(), input.end());
+        auto expected = parse(input).error;
+
+        for (auto error: {
+                 validate(input).error,
+                 validate(list_input).error,
+             }) {
+            ASSERT_EQ(error.code(), expected.code()) << input;
+            ASSERT_EQ(error.offset(), expected.offset());
+        }
+
+        ASSERT_FALSE(validate(input, { .accept_duplicate_keys = true }).error);
+    }
+
+    ASSERT_EQ(validate(keys).error.code(), ParseErrorCode::None);
+    ASSERT_EQ(validate(dup).error.code(), ParseErrorCode::DuplicateKey);
+    ASSERT_EQ(validate(large).error.code(), ParseErrorCode::None);
+    ASSERT_EQ(validate(large_dup).error.code(), ParseErrorCode::DuplicateKey);
+    ASSERT_EQ(validate(huge).error.code(), ParseErrorCode::None);
+    ASSERT_EQ(validate(huge_dup).error.code(), ParseErrorCode::DuplicateKey);
+    ASSERT_FALSE(validate(large, {}, null_alloc).error);
+
+    // A quote right after a number or literal does not start a new token.
+    for (std::string input: { R"([null"a"])", R"({"a": 1"b"})" }) {
+        auto error = validate(input).error;
+
+        ASSERT_EQ(error.code(), ParseErrorCode::UnexpectedToken);
+        ASSERT_EQ(error.offset(), parse(input).error.offset());
+    }
+}
+
+TEST(JSONTest, ParseLazyNumbers)
+{
+    std::string input = R"({"a":1.10,"id":123456789012345678901,"n":-5,)"
+                        R"("big":-1e400,"small":1e-400,"list":[0.5e1,20]})";
+    ParseOptions opts{ .lazy_numbers = true };
+    auto [in, value, error] = parse(input, opts);
+
+    ASSERT_FALSE(error);
+    ASSERT_EQ(parse(input).error.code(), ParseErrorCode::NumberOutOfRange);
+
+    const auto &object = std::as_const(value).get_object();
+    const Document &a = object.at("a");
+    const Document &id = object.at("id");
+
+    ASSERT_TRUE(a.is_float());
+    ASSERT_TRUE(a.is_borrowed());
+    ASSERT_EQ(a.get_number_text(), "1.10");
+    ASSERT_EQ(a.get_float_value(), 1.1);
+    ASSERT_TRUE(id.is_int());
+    ASSERT_EQ(id.get_int_value(), std::numeric_limits<Int>::max());
+    ASSERT_EQ(object.at("n").get_int_value(), -5);
+    ASSERT_EQ(object.at("big").get_float_value(),
+              -std::numeric_limits<Float>::infinity());
+    ASSERT_EQ(object.at("small").get_float_value(), 0.0);
+    ASSERT_TRUE(object.at("small").is_borrowed());
+    ASSERT_DEATH(a.get_float(), "precondition");
+    ASSERT_DEATH(object.at("n").get_int(), "precondition");
+
+    std::string output;
+
+    serialize(value, std::back_inserter(output));
+    ASSERT_EQ(parse(output, opts).value, value);
+    ASSERT_NE(output.find(R"("id":123456789012345678901)"), std::string::npos);
+    ASSERT_NE(output.find(R"("list":[0.5e1,20])"), std::string::npos);
+
+    Document copy = value;
+
+    ASSERT_EQ(copy, value);
+    ASSERT_EQ(copy.get_object().at("a").get_number_text(), "1.10");
+    ASSERT_EQ(output.size(), input.size());
+
+    Document &n = copy.get_object().at("n");
+
+    ++n.get_int();
+    ASSERT_FALSE(n.is_borrowed());
+    ASSERT_EQ(n.get_number_text(), "");
+    ASSERT_EQ(n.get_int(), -4);
+    ASSERT_EQ(std::as_const(n).get_int(), -4);
+    ASSERT_EQ(std::as_const(n).get_int_value(), -4);
+
+    std::string eager_input = R"([1, -2.5, 3e2, "x"])";
+    std::list<char> list_input(eager_input.begin(), eager_input.end());
+    auto lazy = parse(eager_input, opts).value;
+    auto list = parse(list_input, opts).value;
+
+    ASSERT_EQ(lazy, parse(eager_input).value);
+    ASSERT_TRUE(lazy.get_array()[2].is_borrowed());
+    ASSERT_FALSE(list.get_array()[2].is_borrowed());
+    ASSERT_EQ(list, lazy);
+
+    BasicIncrementalParser<std::allocator<std::byte>> parser(opts);
+
+    ASSERT_FALSE(parser.feed(eager_input));
+
+    auto result = parser.finish();
+
+    ASSERT_FALSE(result.error);
+    ASSERT_FALSE(result.value.get_array()[2].is_borrowed());
+    ASSERT_EQ(result.value, lazy);
+
+    // Parses which keep no document still check the range of numbers.
+    std::string big = "[99999999999999999999]";
+    EventBuilder builder;
+
+    ASSERT_EQ(parse_events(big, builder, opts).error.code(),
+              ParseErrorCode::NumberOutOfRange);
+    ASSERT_EQ(validate(big, opts).error.code(),
+              ParseErrorCode::NumberOutOfRange);
+}
+
+TEST(JSONTest, SerializeOutputs)
+{
+    Document value = parse(R"({"a": [1, -2.5, null, true], "b": "x\"y"})")
+                         .value;
+    Array &items = value.get_object()["items"].emplace_array();
+
+    // Enough output to fill several blocks, with strings longer than one.
+    for (int i = 0; i < 200; ++i) {
+        items.emplace_back(String(i * 50, 'a' + i % 26));
+    }
+
+    std::string expected = to_string(value);
+
+    ASSERT_EQ(parse(expected).value, value);
+
+    std::string str;
+    serialize(value, std::back_inserter(str));
+    ASSERT_EQ(str, expected);
+
+    std::list<char> list;
+    serialize(value, std::back_inserter(list));
+    ASSERT_EQ(std::string(list.begin(), list.end()), expected);
+
+    // Only `push_back`, as `std::back_insert_iterator` requires.
+    struct PushOnly {
+        using value_type = char;
+
+        std::string str;
+
+        void push_back(char c)
+        {
+            str.push_back(c);
+        }
+    } push_only;
+
+    serialize(value, std::back_inserter(push_only));
+    ASSERT_EQ(push_only.str, expected);
+
+    std::string buf(expected.size() + 1, '\0');
+    char *end = serialize(value, buf.data());
+    ASSERT_EQ(end, buf.data() + expected.size());
+    ASSERT_EQ(buf.substr(0, expected.size()), expected);
+
+    std::ostringstream stream;
+    stream << value << ' ' << value.get_object()["a"];
+    ASSERT_TRUE(stream);
+    ASSERT_EQ(stream.str(), expected + " [1,-2.5,null,true]");
+
+    std::ostringstream iter_stream;
+    serialize(value, std::ostreambuf_iterator<char>(iter_stream));
+    ASSERT_EQ(iter_stream.str(), expected);
+}
+
+TEST(JSONTest, SerializeStringRuns)
+{
+    const std::string pieces[] = {
+        "a",        "0123456789abcdef", "\"",         "\\",
+        "\n",       "\x1F",             "\x7F",       "\xC3\xA9",
+        "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xC0\x80", "\xED\xA0\x80",
+        "\xEF\xBF\xBF", "\xE2\x82",         "\x80",     "\xFF",
+    };
+
+    auto escape = [](std::string_view value) {
+        std::string dest = "\"";
+        auto first = value.data();
+        auto last = first + value.size();
+
+        while (first != last) {
+            char32_t c;
+
+            if (!json::detail::read_utf8_char(first, last, c)) {
+                c = 0xFFFD;
+            }
+
+            if (c == '"' || c == '\\') {
+                dest += '\\';
+                dest += static_cast<char>(c);
+            } else if (c < 0x20) {
+                char buf[7];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+                dest += buf;
+            } else {
+                json::detail::write_utf8_char(std::back_inserter(dest), c);
+            }
+        }
+
+        return dest + "\"";
+    };
+
+    std::mt19937 engine;
+    std::uniform_int_distribution<std::size_t> dist(0, std::size(pieces) - 1);
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string value;
+
+        for (int j = i % 40; j >= 0; --j) {
+            value += pieces[dist(engine)];
+        }
+
+        ASSERT_EQ(to_string(Document(std::string_view(value))), escape(value));
+    }
+
+    ASSERT_EQ(to_string(Document("a\"b\\c\n\xC3\xA9\xFF\xC0\x80")),
+              "\"a\\\"b\\\\c\\u000a\xC3\xA9\xEF\xBF\xBD\\u0000\"");
+}
+
+TEST(JSONTest, SerializeIndented)
+{
+    Document value = parse(R"([1, [2, {}], {"a": [true]}, []])").value;
+    Document object = parse(R"({"k": [1, {"m": null}]})").value;
+    SerializeOptions opts{ .indent_size = 2 };
+    std::string array_output;
+    std::string object_output;
+
+    serialize(value.get_array(), std::back_inserter(array_output), opts);
+    serialize(object.get_object(), std::back_inserter(object_output), opts);
+
+    ASSERT_EQ(array_output, "[\n"
+                            "  1,\n"
+                            "  [\n"
+                            "    2,\n"
+                            "    {}\n"
+                            "  ],\n"
+                            "  {\n"
+                            "    \"a\":[\n"
+                            "      true\n"
+                            "    ]\n"
+                            "  },\n"
+                            "  []\n"
+                            "]");
+    ASSERT_EQ(object_output, "{\n"
+                             "  \"k\":[\n"
+                             "    1,\n"
+                             "    {\n"
+                             "      \"m\":null\n"
+                             "    }\n"
+                             "  ]\n"
+                             "}");
+
+    std::string document_output;
+
+    serialize(value, std::back_inserter(document_output), opts);
+    ASSERT_EQ(array_output, document_output);
+}
+
+TEST(JSONTest, SerializedSize)
+{
+    Document value = parse(R"({
+        "a": [1, -25, 1.5e300, -0.125, null, true, false, [], {}],
+        "b\n": "x\"y\\z\u0001é€😀",
+        "c": {"d": [[[]], {"e": ""}]}
+    })")
+                         .value;
+
+    for (std::size_t indent_size: { 0, 3 }) {
+        SerializeOptions opts{ .indent_size = indent_size };
+        std::string expected;
+
+        serialize(value, std::back_inserter(expected), opts);
+
+        ASSERT_EQ(serialized_size(value, opts), expected.size());
+
+        std::string buf(expected.size(), '\0');
+        auto [ptr, ec] = serialize_to(value, buf, opts);
+
+        ASSERT_EQ(ec, std::errc());
+        ASSERT_EQ(ptr, buf.data() + buf.size());
+        ASSERT_EQ(buf, expected);
+
+        buf.pop_back();
+        ASSERT_EQ(serialize_to(value, buf, opts).ec,
+                  std::errc::value_too_large);
+        ASSERT_EQ(serialize_to(value, std::span<char>(), opts).ec,
+                  std::errc::value_too_large);
+    }
+
+    auto &array = value.get_object()["a"].get_array();
+    std::string expected;
+
+    serialize(value, std::back_inserter(expected));
+    ASSERT_EQ(to_string(value), expected);
+    ASSERT_EQ(serialized_size(array), 45);
+    ASSERT_EQ(to_string(array),
+              "[1,-25,1.5e+300,-0.125,null,true,false,[],{}]");
+    ASSERT_EQ(to_string(value.get_object()["c"].get_object()),
+              R"({"d":[[[]],{"e":""}]})");
+    ASSERT_EQ(serialized_size(Document()), 4);
+}
+
+TEST(JSONTest, ChunkedSerialize)
+{
+    Document value = parse(R"({
+        "a": [1, -2.5, null, true, [], {}, [[{"b": "c\n"}]]],
+        "d": {"e": "f"}
+    })")
+                         .value;
+    Array &items = value.get_object()["items"].emplace_array();
+
+    for (int i = 0; i < 50; ++i) {
+        items.emplace_back(String(i * 20, 'a' + i % 26));
+    }
+
+    for (std::size_t indent_size: { 0, 2 }) {
+        SerializeOptions opts{ .indent_size = indent_size };
+        std::string expected;
+
+        serialize(value, std::back_inserter(expected), opts);
+
+        for (std::size_t chunk_size: { 1, 7, 64, 4096, 100000 }) {
+            ChunkedSerializer serializer(value, opts);
+            std::string buf(chunk_size, '\0');
+            std::string dest;
+
+            ASSERT_FALSE(serializer.done());
+
+            while (std::size_t size = serializer.next_chunk(buf)) {
+                ASSERT_TRUE(size == chunk_size ||
+                            dest.size() + size == expected.size());
+                dest.append(buf, 0, size);
+            }
+
+            ASSERT_TRUE(serializer.done());
+            ASSERT_EQ(serializer.next_chunk(buf), 0);
+            ASSERT_EQ(dest, expected);
+        }
+    }
+
+    ChunkedSerializer serializer(value);
+    std::string expected = to_string(value);
+    char buf[10];
+    std::string dest;
+
+    static_assert(std::ranges::input_range<ChunkedSerializer::ChunkRange>);
+    ASSERT_EQ(serializer.next_chunk(std::span<char>()), 0);
+
+    for (std::string_view chunk: serializer.chunks(buf)) {
+        ASSERT_LE(chunk.size(), std::size(buf));
+        dest += chunk;
+    }
+
+    ASSERT_TRUE(serializer.done());
+    ASSERT_EQ(dest, expected);
+
+    Document null_value;
+    ChunkedSerializer null_serializer(null_value);
+
+    ASSERT_EQ(null_serializer.next_chunk(buf), 4);
+    ASSERT_EQ(std::string_view(buf, 4), "null");
+    ASSERT_EQ(null_serializer.next_chunk(buf), 0);
+}
+
+TEST(JSONTest, Hash)
+{
+    std::string input =
+        R"({"a": [1, -2.5, "x\ny", null, true], "b": {"c": 0.0, "d": []},)"
+        R"( "e": -1234567890123, "f": 1e300})";
+    Document value = parse(input).value;
+    Document reordered;
+    auto &members = reordered.emplace_object();
+    std::vector<std::pair<String, Document>> entries(
+        value.get_object().begin(), value.get_object().end());
+
+    for (auto first = entries.rbegin(); first != entries.rend(); ++first) {
+        members.emplace(first->first, first->second);
+    }
+
+    members["b"].get_object()["c"] = -0.0;
+
+    std::string in_situ_input = input;
+    Document lazy = parse(input, { .lazy_numbers = true }).value;
+    Document in_situ = parse_in_situ(in_situ_input).value;
+
+    for (auto &other: { reordered, lazy, in_situ }) {
+        ASSERT_EQ(other, value);
+        ASSERT_EQ(json::hash(other), json::hash(value));
+        ASSERT_EQ(std::hash<Document>()(other), json::hash(value));
+    }
+
+    ASSERT_EQ(json::hash(value.get_object()["a"].get_array()),
+              json::hash(lazy.get_object()["a"].get_array()));
+    ASSERT_EQ(json::hash(value.get_object()),
+              json::hash(reordered.get_object()));
+
+    std::unordered_set<std::uint64_t> hashes;
+
+    for (std::string_view other:
+         { "null", "false", "true", "0", "1", "1.0", "\"1\"", "[]", "{}",
+           "[1, 2]", "[2, 1]", "[[1], 2]", "[1, [2]]", R"({"a": 1, "b": 2})",
+           R"({"a": 2, "b": 1})", R"({"a": 1})", R"({"b": 1})",
+           R"(["a", "b"])", R"(["ab"])", R"({"a": {"b": 1}})",
+           R"({"a": {"c": 1}})" }) {
+        ASSERT_TRUE(hashes.insert(json::hash(parse(other).value)).second)
+            << other;
+    }
+
+    std::uint8_t digest[MD5::digest_size];
+    std::uint8_t reordered_digest[MD5::digest_size];
+    MD5 md5;
+    MD5 reordered_md5;
+
+    hash_append(md5, value);
+    hash_append(reordered_md5, reordered);
+    md5.finalize(digest);
+    reordered_md5.finalize(reordered_digest);
+    ASSERT_TRUE(std::ranges::equal(digest, reordered_digest));
+
+    std::unordered_set<Document> set{ value, reordered, lazy, Document() };
+
+    ASSERT_EQ(set.size(), 2);
+    ASSERT_EQ(std::hash<String>()(String("abc")),
+              std::hash<std::string_view>()("abc"));
+}
+
 } // namespace htl::test
@@ -52,6 +52,8 @@ inline const std::vector<ParseSuccessCase> parse_success_cases = {
         "array_ending_with_newline",
         "[\"a\"]\n",
         TestArray{ "a" },
+        {},
+        "\n",
     },
     {
         "array_false",
@@ -87,6 +89,8 @@ inline const std::vector<ParseSuccessCase> parse_success_cases = {
         "array_with_trailing_space",
         "[2] ",
         TestArray{ 2 },
+        {},
+        " ",
     },
     {
         "number",
@@ -113,6 +117,8 @@ inline const std::vector<ParseSuccessCase> parse_success_cases = {
         "-0.000000000000000000000000000000000000000000000000000000000000000000"
         "000000000001\n",
         -1e-78,
+        {},
+        "\n",
     },
     {
         "number_int_with_exp",
@@ -622,6 +628,12 @@ inline const std::vector<ParseSuccessCase> parse_success_cases = {
         TestArray{ "id", 0 },
         { .accept_trailing_commas = true },
     },
+    {
+        "object_with_comments_with_accept_comments",
+        "{\"a\":/*comment*/\"b\", // line\n\"c\": [1 /** x **/, 2]}",
+        TestObject{ { "a", "b" }, { "c", TestArray{ 1, 2 } } },
+        { .accept_comments = true },
+    },
     {
         "string_unpaired_surrogate",
         "\"\\uD800\"",
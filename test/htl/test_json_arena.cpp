@@ -0,0 +1,111 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <htl/json_arena.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+TEST(JsonArenaTest, Allocate)
+{
+    Arena arena({ .initial_block_size = 256, .max_block_size = 1024 });
+
+    ASSERT_EQ(arena.capacity(), 0);
+
+    auto *a = static_cast<char *>(arena.allocate(10, 1));
+    auto *b = static_cast<char *>(arena.allocate(8, 8));
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(b) % 8, 0);
+    ASSERT_GE(b, a + 10);
+    ASSERT_GT(arena.capacity(), 0);
+
+    // Only the last allocation is reclaimed.
+    arena.deallocate(a, 10);
+    ASSERT_EQ(arena.allocate(8, 8), b + 8);
+    arena.deallocate(b + 8, 8);
+    ASSERT_EQ(arena.allocate(8, 8), b + 8);
+
+    auto *aligned = arena.allocate(1, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0);
+
+    // Larger than any block.
+    auto *large = static_cast<char *>(arena.allocate(5000, 16));
+    large[4999] = 1;
+    ASSERT_GE(arena.capacity(), 5000);
+
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(100, 8);
+    }
+
+    std::size_t capacity = arena.capacity();
+
+    arena.reset();
+    ASSERT_EQ(arena.allocate(10, 1), a);
+
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(100, 8);
+    }
+
+    ASSERT_EQ(arena.capacity(), capacity);
+
+    arena.release();
+    ASSERT_EQ(arena.capacity(), 0);
+    ASSERT_NE(arena.allocate(10, 1), nullptr);
+}
+
+TEST(JsonArenaTest, HugePages)
+{
+    Arena arena({ .huge_pages = true });
+
+    auto *p = static_cast<char *>(arena.allocate(100, 8));
+    p[99] = 1;
+    ASSERT_GE(arena.capacity(), std::size_t(1) << 20);
+}
+
+TEST(JsonArenaTest, Parse)
+{
+    std::string input = R"({"a": [1, 2.5, "x\ny", null, true, {"b": []}],)"
+                        R"( "c": ")" + std::string(1000, 'z') + R"("})";
+    Document expected = parse(input).value;
+    Arena arena({ .initial_block_size = 1024 });
+    std::size_t capacity = 0;
+
+    for (int i = 0; i < 10; ++i) {
+        {
+            auto [in, value, error] = parse(input, arena);
+
+            ASSERT_FALSE(error);
+            ASSERT_EQ(in, input.end());
+            ASSERT_EQ(value.get_allocator().arena(), &arena);
+            ASSERT_EQ(to_string(value), to_string(expected));
+            ASSERT_EQ(value.get_object().find("c")->second.get_string_view(),
+                      std::string(1000, 'z'));
+        }
+
+        // Nothing is allocated from the system after the first parse.
+        if (i) {
+            ASSERT_EQ(arena.capacity(), capacity);
+        }
+
+        capacity = arena.capacity();
+        arena.reset();
+    }
+
+    std::vector<char> chars(input.begin(), input.end());
+    auto result = parse(chars.begin(), chars.end(), { .max_depth = 1 }, arena);
+
+    ASSERT_EQ(result.error.code(), ParseErrorCode::MaxDepth);
+
+    arena::Document copy(parse(input, arena).value, arena);
+
+    ASSERT_EQ(to_string(copy), to_string(expected));
+
+    arena::Document inner(copy.get_object().find("a")->second, arena);
+
+    ASSERT_EQ(to_string(inner), R"([1,2.5,"x\u000ay",null,true,{"b":[]}])");
+}
+
+} // namespace htl::test
@@ -0,0 +1,339 @@
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <htl/json_bind.h>
+#include <htl/rational.h>
+#include <htl/uuid.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+namespace {
+
+struct Point {
+    double x;
+    double y;
+
+    bool operator==(const Point &) const = default;
+};
+
+struct Shape {
+    std::string name;
+    std::int8_t layer;
+    bool visible;
+    std::vector<Point> points;
+    std::optional<std::uint32_t> color;
+    std::vector<std::vector<int>> grid;
+    Document extra;
+};
+
+struct Record {
+    UUID id;
+    Rational<int> ratio;
+    std::map<std::string, std::optional<int>> counts;
+    std::vector<std::string> tags;
+};
+
+struct Empty {};
+
+template <class T>
+std::string to_json(const T &value, const SerializeOptions &opts = {})
+{
+    std::string dest;
+
+    serialize(value, std::back_inserter(dest), opts);
+    return dest;
+}
+
+} // namespace
+
+} // namespace htl::test
+
+template <>
+struct htl::json::Bind<htl::test::Point> {
+    static constexpr auto fields = std::tuple(
+        field("x", &htl::test::Point::x), field("y", &htl::test::Point::y));
+};
+
+template <>
+struct htl::json::Bind<htl::test::Shape> {
+    using Shape = htl::test::Shape;
+
+    static constexpr auto fields = std::tuple(
+        field("name", &Shape::name), field("layer", &Shape::layer),
+        field("visible", &Shape::visible), field("points", &Shape::points),
+        field("color", &Shape::color), field("grid", &Shape::grid),
+        field("extra", &Shape::extra));
+};
+
+template <>
+struct htl::json::Bind<htl::test::Record> {
+    using Record = htl::test::Record;
+
+    static constexpr auto fields = std::tuple(
+        field("id", &Record::id), field("ratio", &Record::ratio),
+        field("counts", &Record::counts), field("tags\t\"", &Record::tags));
+};
+
+template <>
+struct htl::json::Bind<htl::test::Empty> {
+    static constexpr auto fields = std::tuple();
+};
+
+namespace htl::test {
+
+TEST(JsonBindTest, ParseInto)
+{
+    std::string input = R"({
+        "name": "triangle",
+        "skip": {"a": [1, {"b": null}], "c": "x"},
+        "layer": -3,
+        "points": [{"x": 1, "y": 2.5}, {"y": -1e2, "z": [true]}, {}],
+        "visible": true,
+        "color": null,
+        "grid": [[1, 2], [], [3]],
+        "extra": {"k": [1, "v"]}
+    } tail)";
+
+    for (auto opts: { ParseOptions(), ParseOptions{ .max_depth = 4 } }) {
+        auto [in, shape, error] = parse_into<Shape>(input, opts);
+
+        ASSERT_FALSE(error);
+        ASSERT_EQ(std::string(in, input.end()), " tail");
+        ASSERT_EQ(shape.name, "triangle");
+        ASSERT_EQ(shape.layer, -3);
+        ASSERT_TRUE(shape.visible);
+        ASSERT_EQ(shape.points, (std::vector<Point>{
+                                    { 1, 2.5 }, { 0, -100 }, { 0, 0 } }));
+        ASSERT_FALSE(shape.color);
+        ASSERT_EQ(shape.grid, (std::vector<std::vector<int>>{
+                                  { 1, 2 }, {}, { 3 } }));
+        ASSERT_EQ(shape.extra, parse(R"({"k": [1, "v"]})").value);
+    }
+
+    std::list<char> list_input(input.begin(), input.end());
+    auto result = parse_into<Shape>(list_input);
+
+    ASSERT_FALSE(result.error);
+    ASSERT_EQ(result.value.name, "triangle");
+    ASSERT_EQ(result.value.points.size(), 3);
+
+    ASSERT_EQ(parse_into<std::optional<int>>("7").value, 7);
+    ASSERT_EQ(parse_into<std::vector<bool>>("[true, false]").value,
+              (std::vector<bool>{ true, false }));
+    ASSERT_EQ(parse_into<double>("3").value, 3.0);
+    ASSERT_EQ(parse_into<std::string>("\"a\\nb\"").value, "a\nb");
+    ASSERT_EQ(parse_into<std::vector<int>>("[1, 2,]",
+                                           { .accept_trailing_commas = true })
+                  .value,
+              (std::vector<int>{ 1, 2 }));
+}
+
+TEST(JsonBindTest, ParseErrors)
+{
+    struct Case {
+        std::string input;
+        ParseErrorCode code;
+    };
+
+    for (auto &[input, code]: std::vector<Case>{
+             { R"({"layer": 300})", ParseErrorCode::NumberOutOfRange },
+             { R"({"layer": 1.5})", ParseErrorCode::TypeMismatch },
+             { R"({"layer": "1"})", ParseErrorCode::TypeMismatch },
+             { R"({"name": 1})", ParseErrorCode::TypeMismatch },
+             { R"({"visible": null})", ParseErrorCode::TypeMismatch },
+             { R"({"points": {}})", ParseErrorCode::TypeMismatch },
+             { R"({"color": -1})", ParseErrorCode::NumberOutOfRange },
+             { R"({"name": "a", "name": "b"})", ParseErrorCode::DuplicateKey },
+             { R"([])", ParseErrorCode::TypeMismatch },
+             { R"({"grid": [[1], [2,]]})", ParseErrorCode::UnexpectedToken },
+             { R"({"skip": [1 2]})", ParseErrorCode::UnexpectedToken },
+             { R"({"skip": {"a" 1}})", ParseErrorCode::UnexpectedToken },
+             { R"({"skip": [tru]})", ParseErrorCode::UnexpectedToken },
+             { R"({"skip": "\x"})", ParseErrorCode::InvalidEscape },
+             { R"({"points": [{"x": 1}})", ParseErrorCode::UnexpectedToken },
+             { R"({"name": "a",})", ParseErrorCode::UnexpectedToken },
+             { R"({"name" "a"})", ParseErrorCode::UnexpectedToken },
+             { R"({"grid": [[[]]]})", ParseErrorCode::TypeMismatch },
+             { R"({"skip": [[[1]]]})", ParseErrorCode::MaxDepth },
+             { R"({"extra": [[[1]]]})", ParseErrorCode::MaxDepth },
+             { R"({"grid": [[1]]})", ParseErrorCode::None },
+         }) {
+        auto result = parse_into<Shape>(input, { .max_depth = 3 });
+
+        ASSERT_EQ(result.error.code(), code) << input;
+
+        if (code != ParseErrorCode::TypeMismatch &&
+            code != ParseErrorCode::NumberOutOfRange) {
+            auto expected = parse(input, { .max_depth = 3 });
+
+            ASSERT_EQ(result.error.offset(), expected.error.offset()) << input;
+            ASSERT_EQ(result.error.line(), expected.error.line());
+            ASSERT_EQ(result.error.column(), expected.error.column());
+        }
+    }
+
+    std::string big = "99999999999999999999";
+
+    ASSERT_EQ(parse_into<std::int64_t>(big).error.code(),
+              ParseErrorCode::NumberOutOfRange);
+    ASSERT_EQ(parse_into<std::int64_t>(big, { .lazy_numbers = true })
+                  .error.code(),
+              ParseErrorCode::NumberOutOfRange);
+}
+
+TEST(JsonBindTest, Serialize)
+{
+    Shape shape{
+        .name = "tri\"angle\n",
+        .layer = -3,
+        .visible = true,
+        .points = { { 1, 2.5 }, { 0, -100 } },
+        .color = std::nullopt,
+        .grid = { { 1, 2 }, {} },
+        .extra = Document(BasicArray<std::allocator<std::byte>>{ 1, "v" }),
+    };
+
+    ASSERT_EQ(to_json(shape),
+              R"({"name":"tri\"angle\u000a","layer":-3,"visible":true,)"
+              R"("points":[{"x":1,"y":2.5},{"x":0,"y":-100}],"color":null,)"
+              R"("grid":[[1,2],[]],"extra":[1,"v"]})");
+
+    auto [in, copy, error] = parse_into<Shape>(to_json(shape));
+
+    ASSERT_FALSE(error);
+    ASSERT_EQ(copy.name, shape.name);
+    ASSERT_EQ(copy.points, shape.points);
+    ASSERT_EQ(copy.grid, shape.grid);
+    ASSERT_EQ(copy.extra, shape.extra);
+
+    Record record{
+        .id = UUID(),
+        .ratio = { 3, 4 },
+        .counts = { { "a", 1 }, { "b", std::nullopt } },
+        .tags = { "x" },
+    };
+
+    ASSERT_EQ(to_json(record),
+              R"({"id":"00000000-0000-0000-0000-000000000000",)"
+              R"("ratio":"3/4","counts":{"a":1,"b":null},)"
+              R"("tags\u0009\"":["x"]})");
+    ASSERT_EQ(to_json(Empty()), "{}");
+    ASSERT_EQ(to_json(std::vector<Point>()), "[]");
+    ASSERT_EQ(to_json(std::optional<int>(5)), "5");
+    ASSERT_EQ(to_json(Point{ 1, 2 }, { .indent_size = 2 }),
+              "{\n  \"x\":1,\n  \"y\":2\n}");
+    ASSERT_EQ(to_json(std::vector<Point>{ { 1, 2 } }, { .indent_size = 2 }),
+              "[\n  {\n    \"x\":1,\n    \"y\":2\n  }\n]");
+    ASSERT_EQ(to_json(std::vector<Document>{ parse("[1, {\"a\": []}]").value },
+                      { .indent_size = 1 }),
+              "[\n [\n  1,\n  {\n   \"a\":[]\n  }\n ]\n]");
+}
+
+TEST(JsonBindTest, ParseSerialized)
+{
+    Record record{
+        .id = make_uuid("0123abcd-4567-89ef-0123-456789abcdef"),
+        .ratio = { -3, 4 },
+        .counts = { { "a", 1 }, { "b", std::nullopt } },
+        .tags = { "x", "y" },
+    };
+
+    auto [in, copy, error] = parse_into<Record>(to_json(record));
+
+    ASSERT_FALSE(error);
+    ASSERT_EQ(copy.id, record.id);
+    ASSERT_EQ(copy.ratio.numer(), -3);
+    ASSERT_EQ(copy.ratio.denom(), 4);
+    ASSERT_EQ(copy.counts, record.counts);
+    ASSERT_EQ(copy.tags, record.tags);
+
+    using Pairs = std::vector<std::pair<std::string, int>>;
+
+    Pairs pairs{ { "b", 1 }, { "a", 2 } };
+    std::unordered_map<std::string, std::deque<int>> lists{ { "a", { 1, 2 } } };
+    Rational<std::int64_t> extreme(std::numeric_limits<std::int64_t>::min(),
+                                   std::numeric_limits<std::int64_t>::max());
+
+    ASSERT_EQ(parse_into<Pairs>(to_json(pairs)).value, pairs);
+    ASSERT_EQ(parse_into<decltype(lists)>(to_json(lists)).value, lists);
+    ASSERT_EQ(parse_into<std::list<int>>(to_json(std::list{ 1, 2 })).value,
+              (std::list{ 1, 2 }));
+    ASSERT_EQ(parse_into<Rational<std::int64_t>>(to_json(extreme))
+                  .value.numer(),
+              extreme.numer());
+    ASSERT_EQ(parse_into<UUID>(R"("{0123abcd-4567-89ef-0123-456789abcdef}")")
+                  .value,
+              record.id);
+    ASSERT_EQ(parse_into<Array>("[1, {}]").value, parse("[1, {}]").value);
+    ASSERT_EQ(parse_into<Object>(R"({"a": []})").value,
+              parse(R"({"a": []})").value);
+    ASSERT_EQ(parse_into<String>(R"("a")").value, "a");
+    ASSERT_EQ(parse_into<Pairs>(R"({"a": 1, "a": 2})",
+                                { .accept_duplicate_keys = true })
+                  .value,
+              (Pairs{ { "a", 1 }, { "a", 2 } }));
+    using Map = std::map<std::string, int>;
+
+    ASSERT_EQ(parse_into<Map>(R"({"a": 1, "a": 2})",
+                              { .accept_duplicate_keys = true })
+                  .value,
+              (Map{ { "a", 2 } }));
+
+    struct Case {
+        std::string input;
+        ParseErrorCode code;
+    };
+
+    for (auto &[input, code]: std::vector<Case>{
+             { R"({"id": "0123abcd"})", ParseErrorCode::TypeMismatch },
+             { R"({"id": "0123abcd-4567-89ef-0123-456789abcdefab"})",
+               ParseErrorCode::TypeMismatch },
+             { R"({"id": 1})", ParseErrorCode::TypeMismatch },
+             { R"({"ratio": "3"})", ParseErrorCode::TypeMismatch },
+             { R"({"ratio": "3/"})", ParseErrorCode::TypeMismatch },
+             { R"({"ratio": "/4"})", ParseErrorCode::TypeMismatch },
+             { R"({"ratio": "3/4x"})", ParseErrorCode::TypeMismatch },
+             { R"({"ratio": "3000000000/4"})",
+               ParseErrorCode::NumberOutOfRange },
+             { R"({"ratio": 0.75})", ParseErrorCode::TypeMismatch },
+             { R"({"counts": []})", ParseErrorCode::TypeMismatch },
+             { R"({"counts": {"a": 1, "a": 2}})",
+               ParseErrorCode::DuplicateKey },
+             { R"({"counts": {"a" 1}})", ParseErrorCode::UnexpectedToken },
+             { R"({"counts": {"a": "1"}})", ParseErrorCode::TypeMismatch },
+         }) {
+        ASSERT_EQ(parse_into<Record>(input).error.code(), code) << input;
+    }
+
+    ASSERT_EQ(parse_into<Pairs>(R"({"a": 1, "a": 2})").error.code(),
+              ParseErrorCode::DuplicateKey);
+    ASSERT_EQ(parse_into<Array>("{}").error.code(),
+              ParseErrorCode::TypeMismatch);
+}
+
+TEST(JsonBindTest, FieldTable)
+{
+    constexpr json::detail::FieldTable<4> table(
+        std::array<std::string_view, 4>{ "id", "name", "", "nam" });
+
+    static_assert(table.find("id") == 0);
+    static_assert(table.find("name") == 1);
+    static_assert(table.find("") == 2);
+    static_assert(table.find("nam") == 3);
+    static_assert(table.find("names") == 4);
+    static_assert(table.find("i") == 4);
+    static_assert(json::detail::BoundFields<Shape>::table.is_perfect);
+}
+
+} // namespace htl::test
@@ -0,0 +1,172 @@
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+#include <htl/json_lazy.h>
+#include "./test_json.h"
+
+namespace htl::test {
+
+using TestLazyValue = BasicLazyValue<TestAlloc>;
+
+namespace {
+
+TestDocument materialize(const TestLazyValue &value, const TestAlloc &alloc)
+{
+    TestDocument dest(alloc);
+
+    switch (value.type()) {
+    case Type::Null:
+        dest = nullptr;
+        break;
+    case Type::Bool:
+        dest = value.get_bool();
+        break;
+    case Type::Int:
+        dest = value.get_int();
+        break;
+    case Type::Float:
+        dest = value.get_float();
+        break;
+    case Type::String:
+        dest = value.get_string();
+        break;
+    case Type::Array: {
+        auto &array = dest.emplace_array();
+
+        for (auto element: value.get_array()) {
+            array.push_back(materialize(element, alloc));
+        }
+
+        EXPECT_EQ(array.size(), value.get_array().size());
+        break;
+    }
+    case Type::Object: {
+        auto &object = dest.emplace_object();
+
+        for (auto [key, element]: value.get_object()) {
+            object.insert_or_assign(key.get_string(),
+                                   materialize(element, alloc));
+        }
+
+        break;
+    }
+    }
+
+    return dest;
+}
+
+} // namespace
+
+TEST(JsonLazyTest, Parse)
+{
+    TestAlloc alloc(1);
+
+    for (auto &test_case: parse_success_cases) {
+        auto result = parse_lazy(test_case.input, test_case.opts, alloc);
+
+        if (test_case.opts.accept_comments) {
+            ASSERT_EQ(result.error.code(), ParseErrorCode::UnsupportedOption);
+            ASSERT_EQ(result.in, test_case.input.begin());
+            ASSERT_TRUE(result.value.is_null());
+            continue;
+        }
+
+        auto expected = parse(test_case.input, test_case.opts, alloc);
+
+        ASSERT_FALSE(result.error) << test_case.name;
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+        ASSERT_EQ(result.error.offset(), expected.error.offset());
+        ASSERT_EQ(result.value.to_document(), test_case.value);
+        ASSERT_EQ(materialize(result.value, alloc), test_case.value);
+        ASSERT_EQ(result.in - test_case.input.begin(),
+                  test_case.input.size() - test_case.remaining.size());
+    }
+
+    for (auto &test_case: parse_fail_cases) {
+        if (test_case.opts.accept_comments) {
+            continue;
+        }
+
+        auto result = parse_lazy(test_case.input, test_case.opts, alloc);
+        auto expected = parse(test_case.input, test_case.opts, alloc);
+
+        ASSERT_EQ(result.error.code(), test_case.code) << test_case.name;
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+        ASSERT_EQ(result.error.offset(), expected.error.offset());
+        ASSERT_TRUE(result.value.is_null());
+    }
+}
+
+TEST(JsonLazyTest, Access)
+{
+    std::string input = R"({
+        "id": 12,
+        "tags": ["a", "b\n", []],
+        "a\u0062": {"x": -1.5e2, "x": true, "y": null},
+        "big": 123456789012345678
+    })";
+
+    auto [in, doc, error] =
+        parse_lazy(input, { .accept_duplicate_keys = true });
+
+    ASSERT_FALSE(error);
+    ASSERT_TRUE(doc.is_object());
+    ASSERT_EQ(doc.get_object().size(), 4);
+
+    auto object = doc.get_object();
+
+    ASSERT_TRUE(object.contains("id"));
+    ASSERT_FALSE(object.contains("ab\n"));
+    ASSERT_TRUE(object["id"].is_int());
+    ASSERT_EQ(object["id"].get_int(), 12);
+    ASSERT_EQ(object["big"].get_int(), 123456789012345678);
+    ASSERT_THROW(object.at("missing"), std::out_of_range);
+    ASSERT_EQ(object.find("missing"), object.end());
+
+    auto tags = object["tags"].get_array();
+
+    ASSERT_EQ(tags.size(), 3);
+    ASSERT_EQ(tags[1].get_string(), "b\n");
+    ASSERT_EQ(tags[1].text(), "\"b\\n\"");
+    ASSERT_TRUE(tags[2].get_array().empty());
+    ASSERT_EQ(tags[2].get_array().begin(), tags[2].get_array().end());
+    ASSERT_THROW(tags.at(3), std::out_of_range);
+
+    auto nested = object["ab"];
+
+    ASSERT_TRUE(nested.is_object());
+    ASSERT_TRUE(nested.get_object()["x"].is_bool());
+    ASSERT_TRUE(nested.get_object()["x"].get_bool());
+    ASSERT_EQ((*nested.get_object().begin()).second.get_float(), -150.0);
+    ASSERT_EQ((*nested.get_object().begin()).second.text(), "-1.5e2");
+    ASSERT_TRUE(nested.get_object()["y"].is_null());
+    ASSERT_EQ(nested.text(), R"({"x": -1.5e2, "x": true, "y": null})");
+
+    LazyDocument copy = doc;
+    doc = LazyDocument();
+
+    ASSERT_TRUE(doc.is_null());
+    ASSERT_EQ(copy.get_object()["tags"].get_array()[0].get_string(), "a");
+    ASSERT_EQ((*copy.get_object().begin()).first.get_string(), "id");
+}
+
+TEST(JsonLazyTest, ParseErrors)
+{
+    for (std::string input:
+         { "{\"a\": 1, \"a\": 2}", "{\"a\": 1, \"\\u0061\": 2}",
+           "{\"a\": {\"b\": 1, \"b\": 2}}", "[1, 2", "[1 2]", "[tru]",
+           "[1e999]", "[99999999999999999999]", "[\"\\x\"]", "{\"a\" 1}",
+           "{\"a\": 1,}", "[[[]]]", "/* */ 1" }) {
+        auto result = parse_lazy(input, { .max_depth = 2 });
+        auto expected = parse(input, { .max_depth = 2 });
+
+        ASSERT_TRUE(result.error) << input;
+        ASSERT_EQ(result.error.code(), expected.error.code()) << input;
+        ASSERT_EQ(result.error.offset(), expected.error.offset()) << input;
+        ASSERT_EQ(result.in, input.begin() + (expected.in - input.begin()));
+    }
+}
+
+} // namespace htl::test
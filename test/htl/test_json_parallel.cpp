@@ -0,0 +1,223 @@
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include <htl/json_parallel.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+namespace {
+
+// Counts allocations of characters, which serialization makes only for the
+// buffers of split containers.
+template <class T>
+struct CharCountingAllocator {
+    using value_type = T;
+
+    static inline std::atomic<std::size_t> char_allocations = 0;
+
+    CharCountingAllocator() noexcept = default;
+
+    template <class U>
+    CharCountingAllocator(const CharCountingAllocator<U> &) noexcept
+    {}
+
+    T *allocate(std::size_t n)
+    {
+        if constexpr (std::same_as<T, char>) {
+            ++CharCountingAllocator<char>::char_allocations;
+        }
+
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    friend bool operator==(
+        const CharCountingAllocator &, const CharCountingAllocator &) noexcept
+    {
+        return true;
+    }
+};
+
+std::string make_array(std::size_t size)
+{
+    std::string input = " [";
+
+    for (std::size_t i = 0; i < size; ++i) {
+        if (i) {
+            input += i % 3 ? "," : " ,\n ";
+        }
+
+        switch (i % 5) {
+        case 0:
+            input += std::to_string(i);
+            break;
+        case 1:
+            input += "{\"a,b\": [" + std::to_string(i) + ", \"]\"], \"c\": {}}";
+            break;
+        case 2:
+            input += "\"x\\\"," + std::string(i % 40, 'y') + "\"";
+            break;
+        case 3:
+            input += "[[], [null, true], {\"d\": [false]}]";
+            break;
+        case 4:
+            input += "-1.5e3";
+            break;
+        }
+    }
+
+    return input + "] ";
+}
+
+void expect_same(const std::string &input, const ParseOptions &opts = {})
+{
+    auto expected = parse(input, opts);
+
+    for (std::size_t thread_count: { 1, 2, 3, 8 }) {
+        for (std::size_t segment_size: { 1, 16, 1000 }) {
+            auto result =
+                parse_parallel(input, opts,
+                               { .thread_count = thread_count,
+                                 .min_segment_size = segment_size });
+
+            ASSERT_EQ(result.in - input.begin(), expected.in - input.begin());
+            ASSERT_EQ(result.value, expected.value);
+            ASSERT_EQ(result.error.code(), expected.error.code());
+            ASSERT_EQ(result.error.line(), expected.error.line());
+            ASSERT_EQ(result.error.column(), expected.error.column());
+            ASSERT_EQ(result.error.offset(), expected.error.offset());
+        }
+    }
+}
+
+template <class T>
+void expect_same_output(const T &value)
+{
+    for (std::size_t indent_size: { 0, 2 }) {
+        std::string expected;
+
+        serialize(value, std::back_inserter(expected),
+                  { .indent_size = indent_size });
+
+        for (std::size_t thread_count: { 1, 2, 3, 8 }) {
+            for (std::size_t segment_size: { 0, 1, 16, 1000 }) {
+                std::string dest;
+
+                serialize_parallel(value, std::back_inserter(dest),
+                                   { .indent_size = indent_size },
+                                   { .thread_count = thread_count,
+                                     .min_segment_size = segment_size });
+                ASSERT_EQ(dest, expected);
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST(JsonParallelTest, ParseArray)
+{
+    for (std::size_t size: { 0, 1, 2, 10, 1000 }) {
+        expect_same(make_array(size));
+    }
+
+    expect_same(make_array(100) + "trailing");
+    expect_same("[[1, 2], [3, 4]]");
+    expect_same("{\"a\": [1, 2, 3]}");
+    expect_same("\"[1, 2, 3]\"");
+}
+
+TEST(JsonParallelTest, ParseErrors)
+{
+    std::string input = make_array(1000);
+
+    expect_same(input.substr(0, input.size() - 2));
+    expect_same(input.substr(0, input.size() / 2));
+    expect_same(input.insert(input.size() / 2, ",,"));
+    expect_same("[1, 2, 3,]");
+    expect_same("[1, 2 3]");
+    expect_same("[1, 2], 3]");
+    expect_same("[[[1]], [[2]]]", { .max_depth = 2 });
+    expect_same("[1, 2, 3,]", { .accept_trailing_commas = true });
+    expect_same("[1, [2,], 3]", { .accept_trailing_commas = true });
+}
+
+TEST(JsonParallelTest, Serialize)
+{
+    Document array = parse(make_array(1000)).value;
+    Document object;
+    auto &members = object.emplace_object();
+
+    for (int i = 0; i < 500; ++i) {
+        members[String(std::to_string(i).c_str())] = array.get_array()[i];
+    }
+
+    for (std::string_view input:
+         { "0", "[]", "{}", "[1]", "[[]]", "{\"a\": {}}", "[1, 2, 3]",
+           "[[[1, 2, 3]]]", "{\"a\": [[1], 2]}" }) {
+        expect_same_output(parse(input).value);
+    }
+
+    expect_same_output(array);
+    expect_same_output(array.get_array());
+    expect_same_output(object);
+    expect_same_output(object.get_object());
+
+    Document wrapped = parse(R"({"a": [{"b": null}]})").value;
+
+    wrapped.get_object()["a"].get_array()[0].get_object()["b"] = object;
+    expect_same_output(wrapped);
+    expect_same_output(wrapped.get_object()["a"].get_array());
+}
+
+TEST(JsonParallelTest, SerializeWrapped)
+{
+    using Alloc = CharCountingAllocator<std::byte>;
+
+    std::string items = make_array(1000);
+    std::string input = R"({"count": 1000, "meta": {"a": [1, 2]}, "data": )"
+                        R"({"items": )" +
+                        items + R"(, "next": null}})";
+    auto value = parse(input, Alloc()).value;
+
+    ASSERT_TRUE(value.is_object());
+    expect_same_output(value);
+    expect_same_output(parse("[1, [2, [3, [4, 5, 6]]], {}, 7]").value);
+
+    for (std::size_t indent_size: { 0, 2 }) {
+        std::string expected;
+        std::string dest;
+
+        serialize(value, std::back_inserter(expected),
+                  { .indent_size = indent_size });
+
+        CharCountingAllocator<char>::char_allocations = 0;
+        serialize_parallel(value, std::back_inserter(dest),
+                           { .indent_size = indent_size },
+                           { .thread_count = 2, .min_segment_size = 16 });
+
+        ASSERT_EQ(dest, expected);
+        ASSERT_GT(CharCountingAllocator<char>::char_allocations, 0);
+    }
+}
+
+TEST(JsonParallelTest, ParseComments)
+{
+    std::string input = "[1, /* , */ 2, // ,\n 3]";
+
+    expect_same(input, { .accept_comments = true });
+    expect_same(input);
+}
+
+} // namespace htl::test
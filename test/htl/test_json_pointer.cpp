@@ -0,0 +1,225 @@
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <htl/json_pointer.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+namespace {
+
+// The example document of RFC 6901, section 5.
+Document make_document()
+{
+    return parse(R"({
+        "foo": ["bar", "baz"],
+        "": 0,
+        "a/b": 1,
+        "c%d": 2,
+        "e^f": 3,
+        "g|h": 4,
+        "i\\j": 5,
+        "k\"l": 6,
+        " ": 7,
+        "m~n": 8,
+        "01": 9,
+        "nested": {"x": [{"y": true}], "z": null}
+    })")
+        .value;
+}
+
+} // namespace
+
+TEST(JsonPointerTest, Resolve)
+{
+    const Document doc = make_document();
+
+    ASSERT_EQ(Pointer("").resolve(doc), &doc);
+    ASSERT_EQ(*Pointer("/foo").resolve(doc), parse(R"(["bar", "baz"])").value);
+    ASSERT_EQ(*Pointer("/foo/0").resolve(doc), "bar");
+    ASSERT_EQ(*Pointer("/").resolve(doc), 0);
+    ASSERT_EQ(*Pointer("/a~1b").resolve(doc), 1);
+    ASSERT_EQ(*Pointer("/c%d").resolve(doc), 2);
+    ASSERT_EQ(*Pointer("/e^f").resolve(doc), 3);
+    ASSERT_EQ(*Pointer("/g|h").resolve(doc), 4);
+    ASSERT_EQ(*Pointer("/i\\j").resolve(doc), 5);
+    ASSERT_EQ(*Pointer("/k\"l").resolve(doc), 6);
+    ASSERT_EQ(*Pointer("/ ").resolve(doc), 7);
+    ASSERT_EQ(*Pointer("/m~0n").resolve(doc), 8);
+    ASSERT_EQ(*Pointer("/01").resolve(doc), 9);
+    ASSERT_EQ(*Pointer("/nested/x/0/y").resolve(doc), true);
+    ASSERT_TRUE(Pointer("/nested/z").resolve(doc)->is_null());
+
+    for (auto missing: { "/foo/2", "/foo/-", "/foo/01", "/foo/x", "/bar",
+                         "/foo/0/0", "/nested/z/a",
+                         "/foo/99999999999999999999999" }) {
+        ASSERT_EQ(Pointer(missing).resolve(doc), nullptr) << missing;
+    }
+
+    Document mutable_doc = doc;
+    *Pointer("/nested/x/0/y").resolve(mutable_doc) = false;
+    ASSERT_EQ(*Pointer("/nested/x/0/y").resolve(mutable_doc), false);
+
+    Pointer pointer("/a~1b/~0");
+
+    ASSERT_EQ(pointer.size(), 2);
+    ASSERT_EQ(pointer[0], "a/b");
+    ASSERT_EQ(pointer[1], "~");
+    ASSERT_EQ(pointer, Pointer("/a~1b/~0"));
+    ASSERT_FALSE(pointer == Pointer("/a~1b"));
+    ASSERT_TRUE(Pointer("").empty());
+
+    for (auto invalid: { "foo", "/~", "/~2", "/a~" }) {
+        ASSERT_THROW(Pointer{ invalid }, std::invalid_argument) << invalid;
+    }
+}
+
+TEST(JsonPointerTest, PointerSet)
+{
+    Document doc = make_document();
+    std::vector<std::string> pointers = {
+        "/nested/x/0/y", "/foo/1", "/nested/z", "/foo/0", "/missing/a",
+        "/nested",       "",       "/foo/9",    "/nested/x/0/y",
+    };
+    PointerSet set;
+    std::vector<std::size_t> ids;
+
+    for (auto &pointer: pointers) {
+        ids.push_back(set.insert(pointer));
+    }
+
+    ASSERT_EQ(set.size(), 8);
+    ASSERT_EQ(ids[0], ids[8]);
+
+    std::vector<Document *> results(set.size(), &doc);
+    set.resolve(doc, std::span(results));
+
+    for (std::size_t i = 0; i < pointers.size(); ++i) {
+        ASSERT_EQ(results[ids[i]], Pointer(pointers[i]).resolve(doc))
+            << pointers[i];
+    }
+
+    const Document &const_doc = doc;
+    std::vector<const Document *> const_results(set.size());
+    set.resolve(const_doc, std::span(const_results));
+
+    ASSERT_EQ(const_results[ids[1]], &doc.get_object()["foo"].get_array()[1]);
+    ASSERT_EQ(const_results[ids[4]], nullptr);
+}
+
+TEST(JsonPointerTest, ParseProjection)
+{
+    std::string input = R"({
+        "skip": {"a": [1, {"b": "}]\\\""}], "c": tru},
+        "foo": ["bar", "baz", {"q": [1, 2]}],
+        "nested": {"x": [{"y": true}, 3], "z": null},
+        "": 0,
+        "last": [1, 2, 3]
+    } tail)";
+
+    PointerSet paths;
+
+    paths.insert("/foo/2/q");
+    paths.insert("/foo/0");
+    paths.insert("/nested/x/0/y");
+    paths.insert("/nested");
+    paths.insert("/");
+    paths.insert("/missing/a");
+    paths.insert("/last/1/x");
+
+    auto expected = parse(R"({
+        "foo": ["bar", null, {"q": [1, 2]}],
+        "nested": {"x": [{"y": true}, 3], "z": null},
+        "": 0
+    })");
+
+    std::list<char> list_input(input.begin(), input.end());
+    auto list_result = parse_projection(list_input, paths);
+
+    ASSERT_FALSE(list_result.error);
+    ASSERT_EQ(list_result.value, expected.value);
+    ASSERT_EQ(std::string(list_result.in, list_input.end()), " tail");
+
+    auto [in, value, error] = parse_projection(input, paths);
+
+    ASSERT_FALSE(error);
+    ASSERT_EQ(value, expected.value);
+    ASSERT_EQ(std::string(in, input.end()), " tail");
+
+    // Pointers that are never found do not stop the parse early.
+    auto unstopped = parse_projection(input, paths, {}, { true });
+
+    ASSERT_FALSE(unstopped.error);
+    ASSERT_EQ(unstopped.value, value);
+    ASSERT_EQ(std::string(unstopped.in, input.end()), " tail");
+
+    PointerSet found;
+
+    found.insert("/foo/1");
+    found.insert("/nested/x");
+    auto stopped = parse_projection(input, found, {}, { true });
+
+    ASSERT_FALSE(stopped.error);
+    ASSERT_EQ(stopped.value,
+              parse(R"({"foo": [null, "baz"], "nested": {"x": [{"y": true},)"
+                    R"( 3]}})")
+                  .value);
+    ASSERT_TRUE(std::string(stopped.in, input.end()).starts_with(
+        ", \"z\": null}"));
+
+    ASSERT_TRUE(parse_projection("[1, 2]", found).value.is_null());
+    ASSERT_EQ(parse_projection("[1, 2]", PointerSet()).value, nullptr);
+
+    PointerSet root;
+
+    root.insert("");
+    ASSERT_EQ(parse_projection(input, root).value, parse(input).value);
+}
+
+TEST(JsonPointerTest, ParseProjectionErrors)
+{
+    PointerSet paths;
+
+    paths.insert("/a/0");
+    paths.insert("/b");
+
+    for (std::string input: {
+             R"({"a": [1 2]})",
+             R"({"a": [1,]})",
+             R"({"a" 1})",
+             R"({"b": [tru]})",
+             R"({"b": "\x"})",
+             R"({"b": 1, "b": 2})",
+             R"({"b": [[[1]]]})",
+             R"({"a": [[[1]]]})",
+             R"({"c": 1)",
+             R"({"c": "1)",
+             R"({"c": [1, 2)",
+             R"({"c": // comment
+                  1})",
+         }) {
+        auto result = parse_projection(input, paths, { .max_depth = 3 });
+        auto expected = parse(input, { .max_depth = 3 });
+
+        ASSERT_TRUE(result.error) << input;
+        ASSERT_EQ(result.error.code(), expected.error.code()) << input;
+        ASSERT_EQ(result.error.offset(), expected.error.offset()) << input;
+        ASSERT_EQ(result.error.line(), expected.error.line());
+        ASSERT_EQ(result.error.column(), expected.error.column());
+    }
+
+    // Values that are not selected are not validated.
+    ASSERT_FALSE(parse_projection(R"({"c": [tru, "]"], "b": 1})", paths).error);
+    ASSERT_FALSE(parse_projection(R"({"b": 1, "b": 2})", paths,
+                                  { .accept_duplicate_keys = true })
+                     .error);
+    ASSERT_EQ(parse_projection(R"({"b": 1, "b": 2})", paths,
+                               { .accept_duplicate_keys = true })
+                  .value,
+              parse(R"({"b": 2})").value);
+}
+
+} // namespace htl::test
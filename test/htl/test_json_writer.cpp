@@ -0,0 +1,183 @@
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <gtest/gtest.h>
+#include <htl/json_writer.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+namespace {
+
+template <class F>
+std::string write_json(F &&f, const SerializeOptions &opts = {})
+{
+    std::string dest;
+    Writer writer(std::back_inserter(dest), opts);
+
+    f(writer);
+    writer.finish();
+    return dest;
+}
+
+} // namespace
+
+TEST(JsonWriterTest, Write)
+{
+    auto write = [](auto &writer) {
+        writer.begin_object();
+        writer.key("name");
+        writer.value("tri\"angle\n");
+        writer.key("points");
+        writer.begin_array();
+        writer.value(1);
+        writer.value(-2.5);
+        writer.value(std::uint64_t(18446744073709551615u));
+        writer.value(nullptr);
+        writer.value(true);
+        writer.begin_array();
+        writer.end_array();
+        writer.begin_object();
+        writer.end_object();
+        writer.begin_array();
+        writer.value(std::string("x"));
+        writer.end_array();
+        writer.end_array();
+        writer.key("extra");
+        writer.value(parse(R"([1, {"a": []}])").value);
+        writer.end_object();
+    };
+
+    ASSERT_EQ(write_json(write),
+              R"({"name":"tri\"angle\u000a","points":[1,-2.5,)"
+              R"(18446744073709551615,null,true,[],{},["x"]],)"
+              R"("extra":[1,{"a":[]}]})");
+    ASSERT_EQ(write_json(write, { .indent_size = 2 }),
+              "{\n"
+              "  \"name\":\"tri\\\"angle\\u000a\",\n"
+              "  \"points\":[\n"
+              "    1,\n"
+              "    -2.5,\n"
+              "    18446744073709551615,\n"
+              "    null,\n"
+              "    true,\n"
+              "    [],\n"
+              "    {},\n"
+              "    [\n"
+              "      \"x\"\n"
+              "    ]\n"
+              "  ],\n"
+              "  \"extra\":[\n"
+              "    1,\n"
+              "    {\n"
+              "      \"a\":[]\n"
+              "    }\n"
+              "  ]\n"
+              "}");
+
+    ASSERT_EQ(write_json([](auto &writer) { writer.value(5); }), "5");
+    ASSERT_EQ(write_json([](auto &writer) {
+                  writer.begin_array();
+                  writer.end_array();
+              }),
+              "[]");
+}
+
+TEST(JsonWriterTest, MatchesSerialize)
+{
+    Array array;
+    Array *inner = &array;
+    std::string dest;
+    Writer writer(std::back_inserter(dest), { .indent_size = 1 });
+
+    // Deep enough for the nesting to outgrow the inline bits.
+    writer.begin_array();
+
+    for (int i = 0; i < 300; ++i) {
+        writer.begin_array();
+        writer.value(i);
+        writer.value(std::string(i, 'a'));
+        inner = &inner->emplace_back(Array()).get_array();
+        inner->emplace_back(i);
+        inner->emplace_back(String(i, 'a'));
+    }
+
+    for (int i = 0; i <= 300; ++i) {
+        writer.end_array();
+    }
+
+    std::string expected;
+
+    serialize(array, std::back_inserter(expected), { .indent_size = 1 });
+    writer.finish();
+    ASSERT_EQ(dest, expected);
+}
+
+TEST(JsonWriterTest, Outputs)
+{
+    std::list<char> list;
+    Writer list_writer(std::back_inserter(list));
+
+    list_writer.begin_array();
+    list_writer.value(1);
+    list_writer.flush();
+    ASSERT_EQ(std::string(list.begin(), list.end()), "[1");
+    list_writer.end_array();
+    list_writer.finish();
+    ASSERT_EQ(std::string(list.begin(), list.end()), "[1]");
+
+    char buf[16]{};
+    Writer pointer_writer(buf);
+
+    pointer_writer.value("abc");
+    ASSERT_EQ(pointer_writer.finish(), buf + 5);
+    ASSERT_EQ(std::string(buf), "\"abc\"");
+}
+
+#if HTL_DEBUG
+TEST(JsonWriterDeathTest, Misuse)
+{
+    std::string dest;
+    auto out = std::back_inserter(dest);
+
+    ASSERT_DEATH(
+        {
+            Writer writer(out);
+            writer.begin_object();
+            writer.value(1);
+        },
+        "precondition");
+    ASSERT_DEATH(
+        {
+            Writer writer(out);
+            writer.begin_array();
+            writer.end_object();
+        },
+        "precondition");
+    ASSERT_DEATH(
+        {
+            Writer writer(out);
+            writer.begin_array();
+            writer.key("a");
+        },
+        "precondition");
+    ASSERT_DEATH(
+        {
+            Writer writer(out);
+            writer.value(1);
+            writer.value(2);
+        },
+        "precondition");
+    ASSERT_DEATH(
+        {
+            Writer writer(out);
+            writer.begin_object();
+            writer.finish();
+        },
+        "precondition");
+}
+#endif
+
+} // namespace htl::test
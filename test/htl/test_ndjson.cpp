@@ -0,0 +1,121 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <htl/ndjson.h>
+
+namespace htl::test {
+
+using namespace htl::json;
+
+namespace {
+
+std::string make_ndjson(std::size_t line_count)
+{
+    std::string input;
+
+    for (std::size_t i = 0; i < line_count; ++i) {
+        switch (i % 7) {
+        case 0:
+            input += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\"]}";
+            break;
+        case 1:
+            input += "  [1, 2.5, null]  \r";
+            break;
+        case 2:
+            input += "";
+            break;
+        case 3:
+            input += "{\"id\": }";
+            break;
+        case 4:
+            input += "\"" + std::string(i % 50, 'x') + "\"";
+            break;
+        case 5:
+            input += "true false";
+            break;
+        case 6:
+            input += "   ";
+            break;
+        }
+
+        input += '\n';
+    }
+
+    return input;
+}
+
+} // namespace
+
+TEST(NdjsonTest, ParseInOrder)
+{
+    std::string input = make_ndjson(2000);
+    auto expected = parse_ndjson(input, {}, { .thread_count = 1 });
+
+    ASSERT_EQ(expected.size(), 1429);
+
+    for (std::size_t thread_count: { 2, 4, 7 }) {
+        for (std::size_t batch_size: { 1, 64, 1000, 1 << 20 }) {
+            auto results = parse_ndjson(
+                input, {},
+                { .thread_count = thread_count, .batch_size = batch_size });
+
+            ASSERT_EQ(results.size(), expected.size());
+
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                ASSERT_EQ(results[i].in, expected[i].in);
+                ASSERT_EQ(results[i].value, expected[i].value);
+                ASSERT_EQ(results[i].error.code(), expected[i].error.code());
+                ASSERT_EQ(results[i].error.line(), expected[i].error.line());
+                ASSERT_EQ(results[i].error.column(),
+                          expected[i].error.column());
+                ASSERT_EQ(results[i].error.offset(),
+                          expected[i].error.offset());
+            }
+        }
+    }
+}
+
+TEST(NdjsonTest, LineErrors)
+{
+    std::string input = "{\"a\": 1}\n\n[1,]\n\"x\" 2\n";
+    auto results = parse_ndjson(input);
+
+    ASSERT_EQ(results.size(), 3);
+
+    ASSERT_EQ(results[0].in, 0);
+    ASSERT_FALSE(results[0].error);
+    ASSERT_EQ(results[0].value, Document(Object({ { "a", 1 } })));
+
+    ASSERT_EQ(results[1].in, 2);
+    ASSERT_EQ(results[1].error.code(), ParseErrorCode::UnexpectedToken);
+    ASSERT_EQ(results[1].error.line(), 2);
+    ASSERT_EQ(results[1].error.column(), 3);
+    ASSERT_EQ(results[1].error.offset(), 13);
+
+    ASSERT_EQ(results[2].in, 3);
+    ASSERT_EQ(results[2].error.code(), ParseErrorCode::UnexpectedToken);
+    ASSERT_EQ(results[2].error.line(), 3);
+    ASSERT_EQ(results[2].error.column(), 4);
+    ASSERT_EQ(results[2].error.offset(), 19);
+}
+
+TEST(NdjsonTest, CallbackException)
+{
+    std::string input = make_ndjson(1000);
+    std::size_t count = 0;
+
+    auto callback = [&](std::size_t, Document &&, const ParseError &) {
+        if (++count == 100) {
+            throw std::runtime_error("stop");
+        }
+    };
+
+    ASSERT_THROW(parse_ndjson(input, callback, {},
+                              { .thread_count = 4, .batch_size = 32 }),
+                 std::runtime_error);
+    ASSERT_EQ(count, 100);
+}
+
+} // namespace htl::test
@@ -64,7 +64,7 @@ struct IdentityAllocator : IdentityAllocatorBase {
         T *p = std::allocator<T>{}.allocate(n);
 
         try {
-            get_map().emplace(p, id);
+            get_map().insert_or_assign(p, id);
         } catch (...) {
             deallocate(p, n);
             throw;
@@ -79,9 +79,10 @@ struct IdentityAllocator : IdentityAllocatorBase {
 
         map_type::iterator it = get_map().find(p);
 
-        HTL_CONTRACT(it != get_map().end());
-        HTL_CONTRACT(it->second == id);
+        HTL_EXPECTS(it != get_map().end());
+        HTL_EXPECTS(it->second == id);
 
+        get_map().erase(it);
         std::allocator<T>{}.deallocate(p, n);
     }
 